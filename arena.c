@@ -0,0 +1,215 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "arena.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// every slab starts with this header, padded so that the objects after it stay aligned to 16 bytes
+typedef struct Slab {
+    struct Slab *next;
+    uint64_t padding;
+} Slab;
+
+// a freed object links to the next free one of its class
+typedef struct FreeObject {
+    struct FreeObject *next;
+} FreeObject;
+
+// header in front of an object too large for the classes, padded like Slab
+typedef struct LargeObject {
+    struct LargeObject *prev, *next;
+    size_t size;
+    uint64_t padding;
+} LargeObject;
+
+typedef struct SizeClass {
+    FreeObject *free;
+    char *next, *end;       // unused rest of the slab the class carves objects out of
+} SizeClass;
+
+struct arena {
+    SizeClass classes[ARENA_CLASSES];
+    Slab *slabs;            // carved into objects
+    Slab *spare;            // kept by ar_reset()
+    LargeObject *large;
+    ArenaStats stats;
+};
+
+
+// class of an object size in [1, ARENA_MAX_OBJECT]
+static unsigned classOf(size_t size) {
+    if (size <= 64)
+        return (unsigned) ((size + 15) / 16) - 1;
+    // the band (2^e, 2^(e+1)] is split into four steps of 2^(e-2) bytes
+    const unsigned e = 63 - (unsigned) __builtin_clzll(size - 1);
+    const size_t step = (size - ((size_t) 1 << e) + ((size_t) 1 << (e - 2)) - 1) >> (e - 2);
+    return 4 + (e - 6) * 4 + (unsigned) step - 1;
+}
+
+
+static size_t classSize(unsigned c) {
+    if (c < 4)
+        return (c + 1) * 16;
+    const unsigned band = (c - 4) / 4, step = (c - 4) % 4 + 1;
+    return ((size_t) 1 << (band + 6)) + step * ((size_t) 1 << (band + 4));
+}
+
+
+arena *ar_new(void) {
+    return heap_calloc(1, sizeof(arena));
+}
+
+
+static void freeSlabs(Slab *s) {
+    while (s) {
+        Slab *next = s->next;
+        free(s);
+        s = next;
+    }
+}
+
+
+static void freeLarge(arena *a) {
+    while (a->large) {
+        LargeObject *next = a->large->next;
+        a->stats.reserved -= a->large->size;
+        free(a->large);
+        a->large = next;
+    }
+}
+
+
+void ar_destroy(arena *a) {
+    if (!a) return;
+    freeSlabs(a->slabs);
+    freeSlabs(a->spare);
+    freeLarge(a);
+    free(a);
+}
+
+
+static void *allocLarge(arena *a, size_t size) {
+    LargeObject *o = heap_malloc(sizeof *o + size);
+    if (!o) return NULL;
+    o->prev = NULL;
+    o->next = a->large;
+    o->size = size;
+    if (a->large)
+        a->large->prev = o;
+    a->large = o;
+    a->stats.reserved += size;
+    a->stats.inUse += size;
+    return o + 1;
+}
+
+
+// start carving a class out of a spare or new slab; return true if out of memory
+static bool refill(arena *a, SizeClass *k) {
+    Slab *s = a->spare;
+    if (s) {
+        a->spare = s->next;
+    } else {
+        s = heap_malloc(ARENA_SLAB_SIZE);
+        if (!s) return true;
+        ++a->stats.slabs;
+        a->stats.reserved += ARENA_SLAB_SIZE;
+    }
+    s->next = a->slabs;
+    a->slabs = s;
+    k->next = (char *) (s + 1);
+    k->end = (char *) s + ARENA_SLAB_SIZE;
+    return false;
+}
+
+
+void *ar_alloc(arena *a, size_t size) {
+    size = size ? size : 1;
+    void *p;
+    if (size > ARENA_MAX_OBJECT) {
+        p = allocLarge(a, size);
+        if (!p) return NULL;
+    } else {
+        const unsigned c = classOf(size);
+        const size_t bytes = classSize(c);
+        SizeClass *k = &a->classes[c];
+        if (k->free) {
+            p = k->free;
+            k->free = k->free->next;
+        } else {
+            if ((size_t) (k->end - k->next) < bytes && refill(a, k))
+                return NULL;
+            p = k->next;
+            k->next += bytes;
+        }
+        a->stats.inUse += bytes;
+    }
+
+    ++a->stats.allocations;
+    a->stats.peakInUse = a->stats.inUse > a->stats.peakInUse ? a->stats.inUse : a->stats.peakInUse;
+    return p;
+}
+
+
+void *ar_calloc(arena *a, size_t size) {
+    void *p = ar_alloc(a, size);
+    if (p) memset(p, 0, size);
+    return p;
+}
+
+
+void ar_free(arena *a, void *p, size_t size) {
+    if (!p) return;
+    size = size ? size : 1;
+    ++a->stats.frees;
+    if (size > ARENA_MAX_OBJECT) {
+        LargeObject *o = (LargeObject *) p - 1;
+        if (o->prev) o->prev->next = o->next;
+        else a->large = o->next;
+        if (o->next) o->next->prev = o->prev;
+        a->stats.reserved -= o->size;
+        free(o);
+        a->stats.inUse -= size;
+        return;
+    }
+
+    const unsigned c = classOf(size);
+    FreeObject *o = p;
+    o->next = a->classes[c].free;
+    a->classes[c].free = o;
+    a->stats.inUse -= classSize(c);
+}
+
+
+void ar_reset(arena *a) {
+    if (a->slabs) {
+        Slab *last = a->slabs;
+        while (last->next)
+            last = last->next;
+        last->next = a->spare;
+        a->spare = a->slabs;
+        a->slabs = NULL;
+    }
+    freeLarge(a);
+    memset(a->classes, 0, sizeof a->classes);
+    a->stats.inUse = 0;
+    ++a->stats.resets;
+}
+
+
+void ar_trim(arena *a) {
+    for (Slab *s = a->spare; s; s = s->next) {
+        --a->stats.slabs;
+        a->stats.reserved -= ARENA_SLAB_SIZE;
+    }
+    freeSlabs(a->spare);
+    a->spare = NULL;
+}
+
+
+void ar_stats(const arena *a, ArenaStats *stats) {
+    *stats = a->stats;
+}
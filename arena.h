@@ -0,0 +1,89 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_ARENA_H
+#define GAMEOFLIFE_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARENA_SLAB_SIZE ((size_t) 256 * 1024)     // bytes allocated from the system at a time
+#define ARENA_MAX_OBJECT ((size_t) 64 * 1024)     // larger objects are passed on to malloc()
+#define ARENA_CLASSES 44
+
+/*
+ * Slab allocator for many small objects of a few sizes. Sizes are rounded up to one of
+ * ARENA_CLASSES size classes: multiples of 16 bytes up to 64, then four classes per doubling,
+ * which wastes at most a fifth of an object. Every slab is carved into objects of one class;
+ * freed objects are kept on a list per class and handed out again first. ar_reset() frees every
+ * object at once and keeps the slabs for reuse, so temporaries of a generation or a cleared world
+ * are released without touching the objects one by one.
+ * Objects are aligned to 16 bytes. An arena must only be used by one thread at a time.
+ */
+typedef struct arena arena;
+
+typedef struct ArenaStats {
+    uint64_t allocations;   // objects handed out since creation
+    uint64_t frees;         // objects given back one by one
+    uint64_t resets;        // calls of ar_reset()
+    uint64_t slabs;         // slabs held, including spare ones
+    uint64_t reserved;      // bytes held: slabs and large objects
+    uint64_t inUse;         // bytes of the objects currently allocated, rounded up to their class
+    uint64_t peakInUse;     // largest inUse seen
+} ArenaStats;
+
+/**
+ * @return new empty arena or NULL if out of memory
+ */
+arena *ar_new(void);
+
+/**
+ * Free an arena along with every object and slab. NULL is ignored.
+ * @param a arena
+ */
+void ar_destroy(arena *a);
+
+/**
+ * Allocate an object.
+ * @param a arena
+ * @param size bytes
+ * @return uninitialised object or NULL if out of memory
+ */
+void *ar_alloc(arena *a, size_t size);
+
+/**
+ * Allocate an object filled with zeros.
+ * @param a arena
+ * @param size bytes
+ * @return zeroed object or NULL if out of memory
+ */
+void *ar_calloc(arena *a, size_t size);
+
+/**
+ * Give back a single object. NULL is ignored.
+ * @param a arena the object was allocated from
+ * @param p object
+ * @param size bytes, as passed when allocating the object
+ */
+void ar_free(arena *a, void *p, size_t size);
+
+/**
+ * Free every object at once. Slabs are kept for the objects allocated next.
+ * @param a arena
+ */
+void ar_reset(arena *a);
+
+/**
+ * Give the slabs not currently carved into objects back to the system, e.g. after ar_reset().
+ * @param a arena
+ */
+void ar_trim(arena *a);
+
+/**
+ * @param a arena
+ * @param stats receives the statistics of the arena
+ */
+void ar_stats(const arena *a, ArenaStats *stats);
+
+#endif //GAMEOFLIFE_ARENA_H
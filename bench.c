@@ -0,0 +1,351 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#define _POSIX_C_SOURCE 200809L
+#include "gol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/*
+ * golbench: generation throughput of the engines on a built-in corpus of patterns.
+ * Every run happens in a child process of its own, so that the peak RSS reported is that
+ * of the run alone. A run ends after the generations of its pattern or once the time
+ * budget is used up, whichever comes first. Only the public API of libgameoflife is used.
+ */
+
+#define MAX_LIST 16
+
+typedef struct BenchCase {
+    const char *name;
+    const char *rle;            // NULL for random soups
+    int32_t soupSize;           // side length of a soup
+    unsigned soupDensity;       // percentage of live cells in a soup
+    uint64_t gens;
+} BenchCase;
+
+typedef struct BenchResult {
+    bool failed;
+    uint64_t generations;
+    uint64_t cellUpdates;       // live cells advanced by one generation
+    uint64_t peakPopulation;
+    uint64_t finalPopulation;
+    double seconds;
+    long peakRSS;               // KiB
+} BenchResult;
+
+typedef struct BenchOptions {
+    const char *engines[MAX_LIST];
+    unsigned engineCount;
+    unsigned threads[MAX_LIST];
+    unsigned threadCount;
+    const char *patterns[MAX_LIST];
+    unsigned patternCount;      // 0 for the whole corpus
+    uint64_t gens;              // 0 for the generations of each pattern
+    double budget;              // seconds per run
+    const char *topology;       // NULL for an infinite plane
+    const char *json;           // file name, "-" for stdout, NULL for no JSON output
+} BenchOptions;
+
+
+static const BenchCase corpus[] = {
+        {"r-pentomino", "x = 3, y = 3\nb2o$2ob$bo!\n", 0, 0, 1103},
+        {"acorn", "x = 7, y = 3\nbo5b$3bo3b$2o2b3o!\n", 0, 0, 5206},
+        {"gosper-gun", "x = 36, y = 9\n24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$"
+                       "10bo5bo7bo$11bo3bo$12b2o!\n", 0, 0, 4000},
+        // Max, a spacefiller: its population grows quadratically like that of a breeder
+        {"max", "x = 27, y = 27\n18bo8b$17b3o7b$12b3o4b2o6b$11bo2b3o2bob2o4b$10bo3bobo2bobo5b$10bo4bobobobob2o2b$"
+                "12bo4bobo3b2o2b$4o5bobo4bo3bob3o2b$o3b2obob3ob2o9b2ob$o5b2o5bo13b$bo2b2obo2bo2bob2o10b$"
+                "7bobobobobobo5b4o$bo2b2obo2bo2bo2b2obob2o3bo$o5b2o3bobobo3b2o5bo$o3b2obob2o2bo2bo2bob2o2bob$"
+                "4o5bobobobobobo7b$10b2obo2bo2bob2o2bob$13bo5b2o5bo$b2o9b2ob3obob2o3bo$2b3obo3bo4bobo5b4o$"
+                "2b2o3bobo4bo12b$2b2obobobobo4bo10b$5bobo2bobo3bo10b$4b2obo2b3o2bo11b$6b2o4b3o12b$7b3o17b$"
+                "8bo18b!\n", 0, 0, 1000},
+        {"soup-256-15", NULL, 256, 15, 1000},
+        {"soup-256-35", NULL, 256, 35, 1000},
+        {"soup-256-50", NULL, 256, 50, 1000},
+        {"soup-1024-35", NULL, 1024, 35, 500},
+        {"soup-2048-35", NULL, 2048, 35, 200}
+};
+
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15u);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+
+// the same soup for every run, centred on the origin
+static GOL_Cells *makeSoup(int32_t size, unsigned density) {
+    GOL_Cells *cells = gol_newCells();
+    uint64_t seed = (uint64_t) size << 8 | density;
+    for (int32_t y = 0; y < size; ++y) {
+        for (int32_t x = 0; x < size; ++x) {
+            if (splitmix64(&seed) % 100 < density)
+                gol_addCell(cells, x - size / 2, y - size / 2, 1);
+        }
+    }
+    return cells;
+}
+
+
+static BenchResult runCase(const char *engine, const BenchCase *c, unsigned threads, const BenchOptions *o) {
+    BenchResult result = {0};
+    const GOL_Settings settings = {.engine = engine, .topology = o->topology, .threads = threads};
+    GOL_Universe *u = gol_create(&settings);
+    // an engine replaced by another one would be measured under the wrong name
+    if (!u || strcmp(gol_engineName(u), engine)) {
+        gol_destroy(u);
+        result.failed = true;
+        return result;
+    }
+
+    GOL_Cells *cells = c->rle ? gol_readRLE(c->rle) : makeSoup(c->soupSize, c->soupDensity);
+    gol_load(u, cells);
+    gol_freeCells(cells);
+
+    const uint64_t gens = o->gens ? o->gens : c->gens;
+    uint64_t population = gol_population(u);
+    result.peakPopulation = population;
+    const double start = now();
+    while (result.generations < gens && now() - start < o->budget) {
+        const uint64_t advanced = gol_advance(u, gens - result.generations);
+        result.generations += advanced;
+        result.cellUpdates += population * advanced;
+        population = gol_population(u);
+        result.peakPopulation = population > result.peakPopulation ? population : result.peakPopulation;
+    }
+    result.seconds = now() - start;
+    result.finalPopulation = population;
+
+    gol_destroy(u);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.peakRSS = usage.ru_maxrss;
+    return result;
+}
+
+
+// run a case in a child process; if that is impossible, in this process with a less precise peak RSS
+static BenchResult runIsolated(const char *engine, const BenchCase *c, unsigned threads, const BenchOptions *o) {
+    int fds[2];
+    if (pipe(fds))
+        return runCase(engine, c, threads, o);
+
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return runCase(engine, c, threads, o);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        const BenchResult result = runCase(engine, c, threads, o);
+        const bool written = write(fds[1], &result, sizeof result) == (ssize_t) sizeof result;
+        _exit(!written);
+    }
+
+    close(fds[1]);
+    BenchResult result = {.failed = true};
+    if (read(fds[0], &result, sizeof result) != (ssize_t) sizeof result)
+        result.failed = true;
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    return result;
+}
+
+
+// split a comma-separated list in place; return true if it has too many items
+static bool splitList(char *s, const char **items, unsigned *count) {
+    *count = 0;
+    for (char *item = strtok(s, ","); item; item = strtok(NULL, ",")) {
+        if (*count == MAX_LIST)
+            return true;
+        items[(*count)++] = item;
+    }
+    return false;
+}
+
+
+static void showHelp(void) {
+    puts(
+        "golbench - generation throughput of the Game of Life engines\n"
+        "\n"
+        "Options:\n"
+        "    -h, --help       - Display this help screen.\n"
+        "    -e               - Comma-separated engines to run (default sorted,hash,tile,hashlife,sweep,\n"
+        "                       sortcount).\n"
+        "    -j               - Comma-separated thread counts to run every engine with (default 1 and all cores).\n"
+        "    -p               - Comma-separated patterns of the corpus to run (default all).\n"
+        "    -g               - Generations per run instead of those of each pattern.\n"
+        "    -t               - Time budget per run in seconds (default 2).\n"
+        "    -topology        - Bounded topology for every run, e.g. T:2048x2048 (dense engine).\n"
+        "    --json           - Write the results as JSON to a file, or to stdout if the file is -.\n"
+        "\n"
+        "Corpus:"
+    );
+    for (size_t i = 0; i < sizeof corpus / sizeof *corpus; ++i)
+        printf("    %-16s - %llu generations\n", corpus[i].name, (unsigned long long) corpus[i].gens);
+}
+
+
+// return true if the program should exit
+static bool parseOptions(int argc, char **argv, BenchOptions *o, int *status) {
+    static char engines[] = "sorted,hash,tile,hashlife,sweep,sortcount";
+    splitList(engines, o->engines, &o->engineCount);
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    o->threads[0] = 1;
+    o->threadCount = 1;
+    if (cores > 1)
+        o->threads[o->threadCount++] = (unsigned) cores;
+    o->budget = 2;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i], *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+            showHelp();
+            *status = 0;
+            return true;
+        }
+
+        bool bad = false;
+        if (!value) {
+            bad = true;
+        } else if (!strcmp(arg, "-e")) {
+            bad = splitList(argv[i + 1], o->engines, &o->engineCount);
+        } else if (!strcmp(arg, "-p")) {
+            bad = splitList(argv[i + 1], o->patterns, &o->patternCount);
+        } else if (!strcmp(arg, "-j")) {
+            const char *items[MAX_LIST];
+            bad = splitList(argv[i + 1], items, &o->threadCount);
+            for (unsigned k = 0; k < o->threadCount && !bad; ++k) {
+                errno = 0;
+                o->threads[k] = (unsigned) strtoul(items[k], NULL, 10);
+                bad = errno || !o->threads[k];
+            }
+        } else if (!strcmp(arg, "-g")) {
+            errno = 0;
+            o->gens = strtoull(value, NULL, 10);
+            bad = errno != 0;
+        } else if (!strcmp(arg, "-t")) {
+            o->budget = strtod(value, NULL);
+            bad = !(o->budget > 0);
+        } else if (!strcmp(arg, "-topology")) {
+            o->topology = value;
+        } else if (!strcmp(arg, "--json")) {
+            o->json = value;
+        } else {
+            fprintf(stderr, "Unknown option \"%s\".\n", arg);
+            *status = 1;
+            return true;
+        }
+
+        if (bad) {
+            fprintf(stderr, "Invalid or missing value for option \"%s\".\n", arg);
+            *status = 1;
+            return true;
+        }
+        ++i;
+    }
+
+    // gol_create() reports unknown engines and topologies and replaces them
+    for (unsigned k = 0; k < o->engineCount; ++k) {
+        const GOL_Settings settings = {.engine = o->engines[k], .topology = o->topology};
+        GOL_Universe *u = gol_create(&settings);
+        const bool usable = u && !strcmp(gol_engineName(u), o->engines[k]);
+        gol_destroy(u);
+        if (!usable) {
+            fprintf(stderr, "Engine \"%s\" cannot run the benchmark.\n", o->engines[k]);
+            *status = 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static bool selected(const BenchOptions *o, const BenchCase *c) {
+    for (unsigned k = 0; k < o->patternCount; ++k) {
+        if (!strcmp(o->patterns[k], c->name))
+            return true;
+    }
+    return !o->patternCount;
+}
+
+
+int main(int argc, char **argv) {
+    BenchOptions o = {0};
+    int status;
+    if (parseOptions(argc, argv, &o, &status))
+        return status;
+
+    const char *kernel = gol_tileKernel();
+    FILE *json = NULL;
+    if (o.json) {
+        json = strcmp(o.json, "-") ? fopen(o.json, "w") : stdout;
+        if (!json) {
+            fprintf(stderr, "Could not open \"%s\" for writing.\n", o.json);
+            return 1;
+        }
+        fprintf(json, "{\n  \"kernel\": \"%s\",\n  \"cores\": %ld,\n  \"budget\": %g,\n  \"results\": [",
+                kernel, sysconf(_SC_NPROCESSORS_ONLN), o.budget);
+    }
+    FILE *table = json == stdout ? stderr : stdout;
+    fprintf(table, "%-10s %-14s %7s %10s %14s %12s %12s %12s\n",
+            "engine", "pattern", "threads", "gens", "gens/s", "ns/update", "peak pop", "peak RSS");
+
+    bool first = true;
+    for (size_t i = 0; i < sizeof corpus / sizeof *corpus; ++i) {
+        if (!selected(&o, &corpus[i]))
+            continue;
+        for (unsigned e = 0; e < o.engineCount; ++e) {
+            const char *engine = o.engines[e];
+            for (unsigned t = 0; t < o.threadCount; ++t) {
+                const BenchResult r = runIsolated(engine, &corpus[i], o.threads[t], &o);
+                if (r.failed) {
+                    fprintf(table, "%-10s %-14s %7u %10s\n", engine, corpus[i].name, o.threads[t], "failed");
+                    continue;
+                }
+
+                const double gensPerSec = r.seconds > 0 ? (double) r.generations / r.seconds : 0;
+                const double nsPerUpdate = r.cellUpdates ? r.seconds * 1e9 / (double) r.cellUpdates : 0;
+                fprintf(table, "%-10s %-14s %7u %10llu %14.1f %12.3f %12llu %9ld KiB\n",
+                        engine, corpus[i].name, o.threads[t], (unsigned long long) r.generations,
+                        gensPerSec, nsPerUpdate, (unsigned long long) r.peakPopulation, r.peakRSS);
+                if (json) {
+                    fprintf(json, "%s\n    {\"engine\": \"%s\", \"pattern\": \"%s\", \"threads\": %u, "
+                                  "\"generations\": %llu, \"seconds\": %.6f, \"gens_per_sec\": %.3f, "
+                                  "\"cell_updates\": %llu, \"ns_per_cell_update\": %.4f, "
+                                  "\"peak_population\": %llu, \"final_population\": %llu, \"peak_rss_kib\": %ld}",
+                            first ? "" : ",", engine, corpus[i].name, o.threads[t],
+                            (unsigned long long) r.generations, r.seconds, gensPerSec,
+                            (unsigned long long) r.cellUpdates, nsPerUpdate,
+                            (unsigned long long) r.peakPopulation, (unsigned long long) r.finalPopulation, r.peakRSS);
+                    first = false;
+                }
+            }
+        }
+    }
+
+    if (json) {
+        fputs("\n  ]\n}\n", json);
+        if (json != stdout)
+            fclose(json);
+    }
+    return 0;
+}
@@ -0,0 +1,260 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "cellset.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+
+
+static uint64_t toItemSize(uint64_t n) {
+    return n * sizeof(Cell);
+}
+
+
+static void swapCells(Cell *a, Cell *b) {
+    const Cell tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+
+static void insertionSort(Cell *cells, uint64_t n) {
+    for (uint64_t i = 1; i < n; ++i) {
+        const Cell c = cells[i];
+        uint64_t j = i;
+        for (; j > 0 && cells[j - 1] > c; --j)
+            cells[j] = cells[j - 1];
+        cells[j] = c;
+    }
+}
+
+
+static void siftDown(Cell *cells, uint64_t i, uint64_t n) {
+    for (uint64_t child; (child = 2 * i + 1) < n; i = child) {
+        if (child + 1 < n && cells[child + 1] > cells[child])
+            ++child;
+        if (cells[i] >= cells[child])
+            return;
+        swapCells(&cells[i], &cells[child]);
+    }
+}
+
+
+static void heapSort(Cell *cells, uint64_t n) {
+    for (uint64_t i = n / 2; i > 0; --i)
+        siftDown(cells, i - 1, n);
+    for (uint64_t end = n - 1; end > 0; --end) {
+        swapCells(&cells[0], &cells[end]);
+        siftDown(cells, 0, end);
+    }
+}
+
+
+// introsort: quicksort on the keys themselves, heapsort once the recursion gets too deep
+// and insertion sort for short ranges; unlike qsort() it never allocates
+static void introSort(Cell *cells, uint64_t n, unsigned depth) {
+    while (n > 16) {
+        if (depth-- == 0) {
+            heapSort(cells, n);
+            return;
+        }
+
+        // median of the first, middle and last cell as the pivot, moved to the front
+        const uint64_t mid = n / 2, last = n - 1;
+        if (cells[mid] < cells[0]) swapCells(&cells[mid], &cells[0]);
+        if (cells[last] < cells[0]) swapCells(&cells[last], &cells[0]);
+        if (cells[last] < cells[mid]) swapCells(&cells[last], &cells[mid]);
+        swapCells(&cells[0], &cells[mid]);
+
+        // Hoare partition into [0, j] and [j + 1, n), neither of them empty
+        const Cell pivot = cells[0];
+        uint64_t i = 0, j = n;
+        for (;;) {
+            while (cells[i] < pivot) ++i;
+            while (cells[--j] > pivot);
+            if (i >= j) break;
+            swapCells(&cells[i++], &cells[j]);
+        }
+
+        // recurse into the smaller part to bound the stack depth
+        if (j + 1 < n - j - 1) {
+            introSort(cells, j + 1, depth);
+            cells += j + 1;
+            n -= j + 1;
+        } else {
+            introSort(cells + j + 1, n - j - 1, depth);
+            n = j + 1;
+        }
+    }
+    insertionSort(cells, n);
+}
+
+
+cellset *cs_sizedNew(uint64_t size) {
+    size = MAX(1, size);
+    cellset *s = heap_malloc(sizeof *s);
+    if (s) s->cells = heap_malloc(toItemSize(size));
+
+    if (!s || !s->cells) {
+        free(s);
+        return NULL;
+    }
+
+    s->len = 0;
+    s->cap = size;
+    return s;
+}
+
+
+cellset *cs_new(void) {
+    return cs_sizedNew(7);
+}
+
+
+void cs_destroy(cellset *s) {
+    if (!s) return;
+    free(s->cells);
+    free(s);
+}
+
+
+bool cs_reserve(cellset *s, uint64_t size) {
+    if (size <= s->cap)
+        return false;
+
+    Cell *cells = heap_realloc(s->cells, toItemSize(size));
+    if (!cells) return true;
+    s->cells = cells;
+    s->cap = size;
+    return false;
+}
+
+
+bool cs_push(cellset *s, Cell c) {
+    if (s->len >= s->cap && cs_reserve(s, (s->cap << 1) | 1))
+        return true;
+
+    s->cells[s->len++] = c;
+    return false;
+}
+
+
+cellset *cs_clear(cellset *s) {
+    s->len = 0;
+    return s;
+}
+
+
+cellset *cs_copy(const cellset *s) {
+    cellset *s2 = cs_sizedNew(s->len);
+    if (!s2) return NULL;
+
+    memcpy(s2->cells, s->cells, toItemSize(s->len));
+    s2->len = s->len;
+    return s2;
+}
+
+
+bool cs_extend(cellset *s1, cellset *s2) {
+    if (s1 == s2)
+        return false;
+
+    const uint64_t extlen = s1->len + s2->len;
+    if (extlen > s1->cap && cs_reserve(s1, extlen))
+        return true;
+
+    memcpy(s1->cells + s1->len, s2->cells, toItemSize(s2->len));
+    s1->len = extlen;
+    s2->len = 0;
+    return false;
+}
+
+
+bool cs_concat(cellset *s1, const cellset *s2) {
+    const uint64_t extlen = s1->len + s2->len;
+    if (extlen > s1->cap && cs_reserve(s1, extlen))
+        return true;
+
+    memcpy(s1->cells + s1->len, s2->cells, toItemSize(s2->len));
+    s1->len = extlen;
+    return false;
+}
+
+
+bool cs_merge(cellset *out, const cellset *a, const cellset *b) {
+    if (cs_reserve(out, a->len + b->len))
+        return true;
+
+    uint64_t i = 0, j = 0, len = 0;
+    while (i < a->len && j < b->len) {
+        const Cell x = a->cells[i], y = b->cells[j];
+        out->cells[len++] = x < y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    memcpy(out->cells + len, a->cells + i, toItemSize(a->len - i));
+    len += a->len - i;
+    memcpy(out->cells + len, b->cells + j, toItemSize(b->len - j));
+    out->len = len + b->len - j;
+    return false;
+}
+
+
+cellset *cs_sort(cellset *s) {
+    if (s->len > 1)
+        introSort(s->cells, s->len, 2 * (64 - (unsigned) __builtin_clzll(s->len)));
+    return s;
+}
+
+
+cellset *cs_unique(cellset *s) {
+    if (s->len == 0)
+        return s;
+
+    uint64_t len = 1;
+    for (uint64_t i = 1; i < s->len; ++i) {
+        if (s->cells[i] != s->cells[len - 1])
+            s->cells[len++] = s->cells[i];
+    }
+
+    s->len = len;
+    return s;
+}
+
+
+int64_t cs_find(const cellset *s, Cell c) {
+    uint64_t lo = 0, hi = s->len;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (s->cells[mid] < c)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < s->len && s->cells[lo] == c ? (int64_t) lo : -1;
+}
+
+
+uint64_t cs_hash(const cellset *s) {
+    uint64_t hash = 0;
+    for (uint64_t i = 0; i < s->len; ++i)
+        hash ^= cell_hash(s->cells[i]);
+    return hash;
+}
+
+
+cellset *cs_remove(cellset *s, Cell c) {
+    uint64_t len = 0;
+    for (uint64_t i = 0; i < s->len; ++i) {
+        if (s->cells[i] != c)
+            s->cells[len++] = s->cells[i];
+    }
+
+    s->len = len;
+    return s;
+}
@@ -0,0 +1,176 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_CELLSET_H
+#define GAMEOFLIFE_CELLSET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * A cell is its coordinate pair packed into a single 64-bit key: the x coordinate occupies
+ * the upper and the y coordinate the lower 32 bits. Both halves are stored with their sign
+ * bit flipped, so that ordering keys as unsigned integers orders cells by x first and y second.
+ * Moving a cell by one unit is plain addition of CELL_DX or CELL_DY as long as the cell does
+ * not sit on the outermost edge of the 32-bit world.
+ */
+typedef uint64_t Cell;
+
+#define CELL_DX ((Cell) 1 << 32)
+#define CELL_DY ((Cell) 1)
+
+static inline Cell cell_make(int32_t x, int32_t y) {
+    return (Cell) ((uint32_t) x ^ 0x80000000u) << 32 | ((uint32_t) y ^ 0x80000000u);
+}
+
+static inline int32_t cell_x(Cell c) {
+    return (int32_t) ((uint32_t) (c >> 32) ^ 0x80000000u);
+}
+
+static inline int32_t cell_y(Cell c) {
+    return (int32_t) ((uint32_t) c ^ 0x80000000u);
+}
+
+/*
+ * Well-mixed hash of a single cell. The hash of a world is the XOR of the hashes of all its
+ * live cells, so it can be kept up to date from births and deaths alone and is the same
+ * no matter how a world is stored.
+ */
+static inline uint64_t cell_hash(Cell c) {
+    c ^= c >> 30;
+    c *= 0xBF58476D1CE4E5B9u;
+    c ^= c >> 27;
+    c *= 0x94D049BB133111EBu;
+    return c ^ c >> 31;
+}
+
+// hash of a cell in a state of a Generations rule; live cells (state 1) hash like cell_hash(), dead ones to 0
+static inline uint64_t cell_stateHash(Cell c, unsigned state) {
+    return state > 1 ? cell_hash(cell_hash(c) + state) : state ? cell_hash(c) : 0;
+}
+
+
+/*
+ * Contiguous array of cells stored by value. The members may be read directly;
+ * use the functions below to modify the set.
+ */
+typedef struct cellset {
+    Cell *cells;
+    uint64_t len;
+    uint64_t cap;
+} cellset;
+
+/**
+ * Create a new cell set with a given initial capacity.
+ * @param size initial capacity; at least 1 is used
+ * @return new cell set or NULL if out of memory
+ */
+cellset *cs_sizedNew(uint64_t size);
+
+/**
+ * Create a new cell set with a small default capacity.
+ * @return new cell set or NULL if out of memory
+ */
+cellset *cs_new(void);
+
+/**
+ * Free a cell set. NULL is ignored.
+ * @param s cell set
+ */
+void cs_destroy(cellset *s);
+
+/**
+ * Append a cell.
+ * @param s cell set
+ * @param c cell
+ * @return true if out of memory, false otherwise
+ */
+bool cs_push(cellset *s, Cell c);
+
+/**
+ * Make sure the set can hold at least size cells without reallocating.
+ * @param s cell set
+ * @param size requested capacity
+ * @return true if out of memory, false otherwise
+ */
+bool cs_reserve(cellset *s, uint64_t size);
+
+/**
+ * Remove all cells. Capacity is retained.
+ * @param s cell set
+ * @return s
+ */
+cellset *cs_clear(cellset *s);
+
+/**
+ * Create an independent copy of a cell set.
+ * @param s cell set
+ * @return new cell set or NULL if out of memory
+ */
+cellset *cs_copy(const cellset *s);
+
+/**
+ * Append all cells of s2 to s1 and clear s2.
+ * @param s1 receiving set
+ * @param s2 donating set
+ * @return true if out of memory (both sets unmodified), false otherwise
+ */
+bool cs_extend(cellset *s1, cellset *s2);
+
+/**
+ * Append all cells of s2 to s1. s2 is left untouched.
+ * @param s1 receiving set
+ * @param s2 donating set
+ * @return true if out of memory (s1 unmodified), false otherwise
+ */
+bool cs_concat(cellset *s1, const cellset *s2);
+
+/**
+ * Merge two sorted sets in one linear pass; cells contained in both are only taken once.
+ * PRE-CONDITION: a and b are sorted and free of duplicates.
+ * @param out receiving set, whose cells are replaced; must be neither a nor b
+ * @param a cell set
+ * @param b cell set
+ * @return true if out of memory (out unmodified), false otherwise
+ */
+bool cs_merge(cellset *out, const cellset *a, const cellset *b);
+
+/**
+ * Sort cells by x, then y.
+ * @param s cell set
+ * @return s
+ */
+cellset *cs_sort(cellset *s);
+
+/**
+ * Remove consecutive duplicates. PRE-CONDITION: set is sorted.
+ * @param s cell set
+ * @return s
+ */
+cellset *cs_unique(cellset *s);
+
+/**
+ * Binary search for a cell. PRE-CONDITION: set is sorted.
+ * @param s cell set
+ * @param c cell
+ * @return index of the cell or -1 if it is not contained
+ */
+int64_t cs_find(const cellset *s, Cell c);
+
+/**
+ * Hash of the set as a world, i.e. the XOR of cell_hash() of all cells. PRE-CONDITION: no duplicates.
+ * @param s cell set
+ * @return world hash
+ */
+uint64_t cs_hash(const cellset *s);
+
+/**
+ * Remove every occurrence of a cell. Order of the remaining cells is preserved.
+ * @param s cell set
+ * @param c cell
+ * @return s
+ */
+cellset *cs_remove(cellset *s, Cell c);
+
+#endif //GAMEOFLIFE_CELLSET_H
@@ -0,0 +1,68 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+
+static const struct GOL_Engine *const engines[] = {
+        &sortedEngine,
+        &hashEngine,
+        &tileEngine,
+        &hashlifeEngine,
+        &denseEngine,
+        &sweepEngine,
+        &sortCountEngine
+};
+
+
+const struct GOL_Engine *engine_find(const char *name) {
+    if (!name)
+        return engines[0];
+
+    for (size_t i = 0; i < sizeof engines / sizeof *engines; ++i) {
+        if (!strcmp(engines[i]->name, name))
+            return engines[i];
+    }
+
+    return NULL;
+}
+
+
+// parse a dimension of a topology; return true on error
+static bool parseDimension(const char **s, int32_t *dimension) {
+    if (!isdigit((unsigned char) **s))
+        return true;
+    errno = 0;
+    char *end;
+    const unsigned long n = strtoul(*s, &end, 10);
+    if (errno || n < 1 || n > INT32_MAX)
+        return true;
+    *dimension = (int32_t) n;
+    *s = end;
+    return false;
+}
+
+
+bool engine_parseTopology(Topology *t, const char *s) {
+    Topology parsed;
+    switch (toupper((unsigned char) *s)) {
+    case 'P': parsed.type = TOPOLOGY_PLANE; break;
+    case 'T': parsed.type = TOPOLOGY_TORUS; break;
+    case 'K': parsed.type = TOPOLOGY_KLEIN; break;
+    default: return true;
+    }
+
+    s += 1 + (s[1] == ':');
+    if (parseDimension(&s, &parsed.width) || (*s != 'x' && *s != ','))
+        return true;
+    ++s;
+    if (parseDimension(&s, &parsed.height) || *s)
+        return true;
+
+    *t = parsed;
+    return false;
+}
@@ -0,0 +1,95 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_ENGINE_H
+#define GAMEOFLIFE_ENGINE_H
+
+#include "cellset.h"
+#include "rules.h"
+#include "arena.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// shape of the universe; bounded topologies span the cells 0 <= x < width, 0 <= y < height
+typedef enum TopologyType {
+    TOPOLOGY_INFINITE, TOPOLOGY_PLANE, TOPOLOGY_TORUS, TOPOLOGY_KLEIN
+} TopologyType;
+
+typedef struct Topology {
+    TopologyType type;
+    int32_t width, height;
+} Topology;
+
+// everything an engine needs to know when it is created
+typedef struct EngineConfig {
+    Rules rules;
+    Topology topology;          // only the dense engine supports bounded topologies, and only those
+    uint64_t memoryBudget;      // bytes an engine may use for caches; 0 for the engine's default
+    unsigned threads;           // worker threads for engines that step in parallel; 0 or 1 for none
+} EngineConfig;
+
+// inclusive bounds of a rectangular region of the world
+typedef struct CellRect {
+    int32_t x0, y0, x1, y1;
+} CellRect;
+
+/*
+ * A simulation engine owns the world it computes. Every engine exports its functions
+ * through one of these tables; the state pointer returned by create() is passed back
+ * to every other function.
+ */
+struct GOL_Engine {
+    const char *name;
+    void *(*create)(const EngineConfig *config);
+    void (*destroy)(void *world);
+    // advance the world by one generation
+    void (*step)(void *world);
+    // add every cell of the set to the world
+    void (*load)(void *world, const cellset *cells);
+    void (*setCell)(void *world, Cell c, bool alive);
+    // call f for every live cell inside r; cells may be visited in any order
+    void (*forEachInRect)(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg);
+    uint64_t (*population)(void *world);
+    void (*clear)(void *world);
+    // advance by at most gens generations in one go and return how many were advanced;
+    // NULL if the engine can only advance one generation at a time
+    uint64_t (*jump)(void *world, uint64_t gens);
+    // world hash as defined by cell_hash(), cheap enough to be called every generation;
+    // NULL if the engine does not keep track of it
+    uint64_t (*hash)(void *world);
+    // replace the rules; the world itself is kept as it is
+    void (*setRules)(void *world, const Rules *rules);
+    // multi-state support for Generations rules; NULL if the engine only knows dead and alive.
+    // forEachInRect() only visits live cells (state 1), forEachStateInRect() every cell not in state 0
+    void (*setState)(void *world, Cell c, uint8_t state);
+    void (*forEachStateInRect)(void *world, const CellRect *r, void (*f)(Cell, uint8_t, void *), void *arg);
+    // statistics of the arena the world allocates from; NULL if the engine does not use one
+    void (*arenaStats)(void *world, ArenaStats *stats);
+};
+
+extern const struct GOL_Engine sortedEngine;
+extern const struct GOL_Engine hashEngine;
+extern const struct GOL_Engine tileEngine;
+extern const struct GOL_Engine hashlifeEngine;
+extern const struct GOL_Engine denseEngine;
+extern const struct GOL_Engine sweepEngine;
+extern const struct GOL_Engine sortCountEngine;
+
+/**
+ * Look up an engine by name.
+ * @param name engine name; NULL selects the default engine
+ * @return the engine or NULL if there is no engine of that name
+ */
+const struct GOL_Engine *engine_find(const char *name);
+
+/**
+ * Parse a topology of the form T:WxH, where T is P (plane), T (torus) or K (Klein bottle)
+ * and W and H are the width and height of the universe, e.g. T:640x480.
+ * @param t receives the topology; unchanged on error
+ * @param s topology string
+ * @return true if the string is malformed
+ */
+bool engine_parseTopology(Topology *t, const char *s);
+
+#endif //GAMEOFLIFE_ENGINE_H
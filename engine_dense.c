@@ -0,0 +1,267 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "tilekernel.h"
+#include "threadpool.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Dense engine for bounded topologies: the world is one contiguous bit grid of width x height cells,
+ * so there is nothing to hash, sort or look up. The grid is stored in columns of 64-bit words; bit n
+ * of word y of column k holds cell (64k + n, y). Every column carries one halo row above and below
+ * the grid, and the grid has one halo column on either side. Before every step the halo is filled
+ * according to the topology, after which every column is computed by the tile kernels in blocks of
+ * 64 rows without a single bounds check, streaming through memory in order.
+ *
+ * Torus:        both pairs of edges are joined.
+ * Klein bottle: the left and right edges are joined, the top and bottom edges are joined with a twist.
+ * Plane:        everything outside the grid is dead.
+ */
+
+typedef struct DenseWorld {
+    Topology topology;
+    uint64_t *grid[2];          // current generation is grid[phase]
+    int phase;
+    uint64_t columns;           // columns of words holding cells, excluding the two halo columns
+    uint64_t stride;            // words per column: the halo rows and the rows padded to a multiple of 64
+    uint64_t lastMask;          // cells of the last column inside the grid
+    uint64_t *columnPopulation; // population of every column after the last step
+    uint64_t population;
+    Rules rules;
+    bool totalistic;
+    uint16_t birth;
+    uint16_t survival;
+    TileKernel kernel;
+    threadpool *pool;
+} DenseWorld;
+
+
+// column k (0 and columns + 1 are the halo columns) of a grid; index y + 1 holds row y
+static uint64_t *column(const DenseWorld *w, uint64_t *grid, uint64_t k) {
+    return grid + k * w->stride;
+}
+
+
+// cell x of row y of the current generation, halo cells included
+static bool getBit(const DenseWorld *w, int64_t x, int64_t y) {
+    const uint64_t *word = column(w, w->grid[w->phase], (uint64_t) (x + 64) / 64) + y + 1;
+    return (*word >> ((x + 64) % 64)) & 1;
+}
+
+
+static void setBit(const DenseWorld *w, int64_t x, int64_t y, bool alive) {
+    uint64_t *word = column(w, w->grid[w->phase], (uint64_t) (x + 64) / 64) + y + 1;
+    const uint64_t bit = (uint64_t) 1 << ((x + 64) % 64);
+    *word = alive ? *word | bit : *word & ~bit;
+}
+
+
+// map a cell onto the grid; return false if it lies outside a plane
+static bool locate(const DenseWorld *w, int64_t *x, int64_t *y) {
+    const int64_t width = w->topology.width, height = w->topology.height;
+    if (w->topology.type == TOPOLOGY_PLANE)
+        return 0 <= *x && *x < width && 0 <= *y && *y < height;
+
+    const int64_t wraps = *y >= 0 ? *y / height : -((-*y - 1) / height) - 1;
+    *y -= wraps * height;
+    if (w->topology.type == TOPOLOGY_KLEIN && wraps % 2)
+        *x = width - 1 - *x;
+    *x = (*x % width + width) % width;
+    return true;
+}
+
+
+// the halo of a plane is never written, so only wrapping topologies need it filled
+static void fillHalo(DenseWorld *w) {
+    const int64_t width = w->topology.width, height = w->topology.height;
+    uint64_t *grid = w->grid[w->phase];
+
+    if (w->topology.type == TOPOLOGY_TORUS) {
+        for (uint64_t k = 1; k <= w->columns; ++k) {
+            uint64_t *col = column(w, grid, k);
+            col[0] = col[height];
+            col[height + 1] = col[1];
+        }
+    } else if (w->topology.type == TOPOLOGY_KLEIN) {
+        for (int64_t x = 0; x < width; ++x) {
+            setBit(w, x, -1, getBit(w, width - 1 - x, height - 1));
+            setBit(w, x, height, getBit(w, width - 1 - x, 0));
+        }
+    } else {
+        return;
+    }
+
+    for (int64_t y = -1; y <= height; ++y) {
+        setBit(w, -1, y, getBit(w, width - 1, y));
+        setBit(w, width, y, getBit(w, 0, y));
+    }
+}
+
+
+static void stepColumn(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    DenseWorld *w = world;
+    const uint64_t k = task + 1;
+    const uint64_t *west = column(w, w->grid[w->phase], k - 1);
+    const uint64_t *m = column(w, w->grid[w->phase], k);
+    const uint64_t *east = column(w, w->grid[w->phase], k + 1);
+    uint64_t *next = column(w, w->grid[!w->phase], k) + 1;
+    const uint64_t mask = k == w->columns ? w->lastMask : ~(uint64_t) 0;
+
+    uint64_t population = 0;
+    for (int64_t y0 = 0; y0 < w->topology.height; y0 += TILE_SIZE) {
+        uint64_t l[TILE_SIZE + 2], r[TILE_SIZE + 2], out[TILE_SIZE];
+        for (int i = 0; i < TILE_SIZE + 2; ++i) {
+            l[i] = m[y0 + i] << 1 | west[y0 + i] >> (TILE_SIZE - 1);
+            r[i] = m[y0 + i] >> 1 | east[y0 + i] << (TILE_SIZE - 1);
+        }
+
+        if (w->totalistic)
+            w->kernel(l, m + y0, r, out, w->birth, w->survival);
+        else
+            tileKernel_lookup(l, m + y0, r, out, &w->rules);
+
+        // rows past the bottom edge are padding and stay dead
+        const int64_t rows = w->topology.height - y0 < TILE_SIZE ? w->topology.height - y0 : TILE_SIZE;
+        for (int64_t i = 0; i < rows; ++i) {
+            next[y0 + i] = out[i] & mask;
+            population += __builtin_popcountll(next[y0 + i]);
+        }
+    }
+    w->columnPopulation[task] = population;
+}
+
+
+static void setRules(void *world, const Rules *rules) {
+    DenseWorld *w = world;
+    w->rules = *rules;
+    w->totalistic = rules_totalistic(&w->rules);
+    rules_counts(&w->rules, &w->birth, &w->survival);
+}
+
+
+static void destroy(void *world) {
+    DenseWorld *w = world;
+    tp_destroy(w->pool);
+    free(w->grid[0]);
+    free(w->grid[1]);
+    free(w->columnPopulation);
+    free(w);
+}
+
+
+static void *create(const EngineConfig *config) {
+    const Topology *t = &config->topology;
+    if (t->type == TOPOLOGY_INFINITE || t->width < 1 || t->height < 1)
+        return NULL;
+
+    DenseWorld *w = heap_calloc(1, sizeof *w);
+    if (!w) return NULL;
+
+    w->topology = *t;
+    w->columns = ((uint64_t) t->width + TILE_SIZE - 1) / TILE_SIZE;
+    w->stride = ((uint64_t) t->height + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE + 2;
+    w->lastMask = t->width % TILE_SIZE ? ((uint64_t) 1 << t->width % TILE_SIZE) - 1 : ~(uint64_t) 0;
+    w->grid[0] = heap_calloc((w->columns + 2) * w->stride, sizeof *w->grid[0]);
+    w->grid[1] = heap_calloc((w->columns + 2) * w->stride, sizeof *w->grid[1]);
+    w->columnPopulation = heap_calloc(w->columns, sizeof *w->columnPopulation);
+    w->pool = tp_new(config->threads);
+    if (!w->grid[0] || !w->grid[1] || !w->columnPopulation || !w->pool) {
+        destroy(w);
+        return NULL;
+    }
+
+    setRules(w, &config->rules);
+    w->kernel = tileKernel_select(NULL);
+    return w;
+}
+
+
+static void step(void *world) {
+    DenseWorld *w = world;
+    fillHalo(w);
+    tp_run(w->pool, w->columns, stepColumn, w);
+    w->phase = !w->phase;
+
+    w->population = 0;
+    for (uint64_t k = 0; k < w->columns; ++k)
+        w->population += w->columnPopulation[k];
+}
+
+
+// cells outside a plane are ignored, on the other topologies they wrap around
+static void setCell(void *world, Cell c, bool alive) {
+    DenseWorld *w = world;
+    int64_t x = cell_x(c), y = cell_y(c);
+    if (!locate(w, &x, &y) || getBit(w, x, y) == alive)
+        return;
+    setBit(w, x, y, alive);
+    w->population += alive ? 1 : -1;
+}
+
+
+static void load(void *world, const cellset *cells) {
+    for (uint64_t i = 0; i < cells->len; ++i)
+        setCell(world, cells->cells[i], true);
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    DenseWorld *w = world;
+    const int64_t x0 = r->x0 > 0 ? r->x0 : 0, y0 = r->y0 > 0 ? r->y0 : 0;
+    const int64_t x1 = r->x1 < w->topology.width - 1 ? r->x1 : w->topology.width - 1;
+    const int64_t y1 = r->y1 < w->topology.height - 1 ? r->y1 : w->topology.height - 1;
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    for (int64_t k = x0 / TILE_SIZE; k <= x1 / TILE_SIZE; ++k) {
+        uint64_t columns = ~(uint64_t) 0;
+        if (x0 > k * TILE_SIZE)
+            columns &= ~(uint64_t) 0 << (x0 - k * TILE_SIZE);
+        if (x1 < k * TILE_SIZE + TILE_SIZE - 1)
+            columns &= ~(uint64_t) 0 >> (TILE_SIZE - 1 - (x1 - k * TILE_SIZE));
+
+        const uint64_t *col = column(w, w->grid[w->phase], k + 1) + 1;
+        for (int64_t y = y0; y <= y1; ++y) {
+            for (uint64_t bits = col[y] & columns; bits; bits &= bits - 1)
+                f(cell_make((int32_t) (k * TILE_SIZE + __builtin_ctzll(bits)), (int32_t) y), arg);
+        }
+    }
+}
+
+
+static uint64_t population(void *world) {
+    DenseWorld *w = world;
+    return w->population;
+}
+
+
+static void clear(void *world) {
+    DenseWorld *w = world;
+    memset(w->grid[0], 0, (w->columns + 2) * w->stride * sizeof *w->grid[0]);
+    memset(w->grid[1], 0, (w->columns + 2) * w->stride * sizeof *w->grid[1]);
+    w->population = 0;
+}
+
+
+const struct GOL_Engine denseEngine = {
+        "dense",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        NULL,
+        NULL,
+        setRules,
+        NULL,
+        NULL,
+        NULL
+};
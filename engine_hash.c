@@ -0,0 +1,281 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Every live cell scatters its position into the neighbourhoods of the cells around it, kept
+ * in an open-addressing hash table; the next state is then a lookup in the rule table.
+ * The next generation is collected from that table in a single pass, so a generation
+ * costs O(n) instead of O(n log n) and never searches the population.
+ *
+ * The world hash is updated from the births and deaths found in that pass.
+ *
+ * The key of cell (INT32_MAX, INT32_MAX) is reserved to mark empty slots.
+ */
+
+#define EMPTY_SLOT UINT64_MAX
+
+typedef struct HashWorld {
+    cellset *live;      // unsorted; cells placed twice are only removed by deduplicate() or the next step
+    Cell *keys;
+    uint16_t *neighbourhoods;   // live cells around and at the cell, see rules.h
+    uint64_t cap;       // always a power of two
+    uint64_t used;
+    int shift;
+    Rules rules;
+    uint64_t hash;
+    bool hashValid;     // false after edits until duplicates are removed
+} HashWorld;
+
+
+static uint64_t slotOf(const HashWorld *w, Cell c) {
+    return (c * 0x9E3779B97F4A7C15u) >> w->shift;
+}
+
+
+// return true if out of memory
+static bool allocTable(HashWorld *w, uint64_t cap) {
+    Cell *keys = heap_malloc(cap * sizeof *keys);
+    uint16_t *neighbourhoods = heap_malloc(cap * sizeof *neighbourhoods);
+    if (!keys || !neighbourhoods) {
+        free(keys);
+        free(neighbourhoods);
+        return true;
+    }
+
+    free(w->keys);
+    free(w->neighbourhoods);
+    w->keys = keys;
+    w->neighbourhoods = neighbourhoods;
+    w->cap = cap;
+    w->shift = 64 - __builtin_ctzll(cap);
+    return false;
+}
+
+
+static void resetTable(HashWorld *w) {
+    memset(w->keys, 0xFF, w->cap * sizeof *w->keys);
+    memset(w->neighbourhoods, 0, w->cap * sizeof *w->neighbourhoods);
+    w->used = 0;
+}
+
+
+static uint64_t findSlot(const HashWorld *w, Cell c) {
+    const uint64_t mask = w->cap - 1;
+    uint64_t i = slotOf(w, c);
+    while (w->keys[i] != c && w->keys[i] != EMPTY_SLOT)
+        i = (i + 1) & mask;
+    return i;
+}
+
+
+static void grow(HashWorld *w) {
+    Cell *oldKeys = w->keys;
+    uint16_t *oldNeighbourhoods = w->neighbourhoods;
+    uint64_t oldCap = w->cap;
+    w->keys = NULL;
+    w->neighbourhoods = NULL;
+
+    if (allocTable(w, oldCap << 1)) {
+        fprintf(stderr, "Hash engine ran out of memory.\n");
+        abort();
+    }
+
+    resetTable(w);
+    for (uint64_t i = 0; i < oldCap; ++i) {
+        if (oldKeys[i] == EMPTY_SLOT)
+            continue;
+        uint64_t j = findSlot(w, oldKeys[i]);
+        w->keys[j] = oldKeys[i];
+        w->neighbourhoods[j] = oldNeighbourhoods[i];
+        ++w->used;
+    }
+
+    free(oldKeys);
+    free(oldNeighbourhoods);
+}
+
+
+// return the slot of the cell, claiming a new one if necessary
+static uint64_t claimSlot(HashWorld *w, Cell c) {
+    uint64_t i = findSlot(w, c);
+    if (w->keys[i] == EMPTY_SLOT) {
+        if (++w->used > w->cap >> 1) {
+            --w->used;
+            grow(w);
+            return claimSlot(w, c);
+        }
+        w->keys[i] = c;
+    }
+    return i;
+}
+
+
+// remove the duplicates edits may have left in the live cells and rebuild the hash from them
+static void deduplicate(HashWorld *w) {
+    if (w->hashValid)
+        return;
+    cs_unique(cs_sort(w->live));
+    w->hash = cs_hash(w->live);
+    w->hashValid = true;
+}
+
+
+static void *create(const EngineConfig *config) {
+    HashWorld *w = heap_calloc(1, sizeof *w);
+    if (!w) return NULL;
+    w->live = cs_new();
+    if (!w->live || allocTable(w, 1024)) {
+        cs_destroy(w->live);
+        free(w);
+        return NULL;
+    }
+
+    w->rules = config->rules;
+    w->hashValid = true;
+    return w;
+}
+
+
+static void destroy(void *world) {
+    HashWorld *w = world;
+    cs_destroy(w->live);
+    free(w->keys);
+    free(w->neighbourhoods);
+    free(w);
+}
+
+
+static void step(void *world) {
+    HashWorld *w = world;
+
+    // most soups touch about four distinct cells per live cell; keep the load factor below one half.
+    // The table only shrinks once it is four times too large, so that a population swinging around
+    // a power of two does not reallocate it every generation. If the new table cannot be had, the
+    // current one is kept: claimSlot() grows it as needed, or reports running out of memory
+    uint64_t cap = 1024;
+    while (cap < w->live->len * 8)
+        cap <<= 1;
+    if (cap > w->cap || cap * 4 < w->cap)
+        allocTable(w, cap);
+    resetTable(w);
+    if (!w->hashValid)
+        w->hash = 0;    // rebuilt from the distinct live cells below
+
+    for (uint64_t i = 0; i < w->live->len; ++i) {
+        const Cell c = w->live->cells[i];
+        uint64_t slot = claimSlot(w, c);
+        if (w->neighbourhoods[slot] & RULES_CENTRE)
+            continue;   // placed twice
+        w->neighbourhoods[slot] |= RULES_CENTRE;
+        if (!w->hashValid)
+            w->hash ^= cell_hash(c);
+
+        for (int64_t offsetX = -1; offsetX <= +1; ++offsetX) {
+            for (int64_t offsetY = -1; offsetY <= +1; ++offsetY) {
+                if (offsetX == 0 && offsetY == 0)
+                    continue;
+                // claimSlot() may grow the table, so it must run before neighbourhoods is read;
+                // seen from the neighbour, this cell sits at the opposite offset
+                uint64_t neighbour = claimSlot(w, c + (Cell) offsetX * CELL_DX + (Cell) offsetY * CELL_DY);
+                w->neighbourhoods[neighbour] |= RULES_BIT(-offsetX, -offsetY);
+            }
+        }
+    }
+
+    cs_clear(w->live);
+    for (uint64_t i = 0; i < w->cap; ++i) {
+        if (w->keys[i] == EMPTY_SLOT)
+            continue;
+        const uint16_t neighbourhood = w->neighbourhoods[i];
+        const bool alive = neighbourhood & RULES_CENTRE;
+        const bool next = rules_next(&w->rules, neighbourhood);
+        if (next)
+            cs_push(w->live, w->keys[i]);
+        if (next != alive)
+            w->hash ^= cell_hash(w->keys[i]);
+    }
+    w->hashValid = true;
+}
+
+
+static void load(void *world, const cellset *cells) {
+    HashWorld *w = world;
+    cs_concat(w->live, cells);
+    w->hashValid = false;
+}
+
+
+static void setCell(void *world, Cell c, bool alive) {
+    HashWorld *w = world;
+    if (alive)
+        cs_push(w->live, c);
+    else
+        cs_remove(w->live, c);
+    w->hashValid = false;
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    HashWorld *w = world;
+    deduplicate(w);
+    for (uint64_t i = 0; i < w->live->len; ++i) {
+        Cell c = w->live->cells[i];
+        int32_t x = cell_x(c), y = cell_y(c);
+        if (r->x0 <= x && x <= r->x1 && r->y0 <= y && y <= r->y1)
+            f(c, arg);
+    }
+}
+
+
+static uint64_t population(void *world) {
+    HashWorld *w = world;
+    deduplicate(w);
+    return w->live->len;
+}
+
+
+static void clear(void *world) {
+    HashWorld *w = world;
+    cs_clear(w->live);
+    w->hash = 0;
+    w->hashValid = true;
+}
+
+
+static void setRules(void *world, const Rules *rules) {
+    HashWorld *w = world;
+    w->rules = *rules;
+}
+
+
+static uint64_t hash(void *world) {
+    HashWorld *w = world;
+    deduplicate(w);
+    return w->hash;
+}
+
+
+const struct GOL_Engine hashEngine = {
+        "hash",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        NULL,
+        hash,
+        setRules,
+        NULL,
+        NULL,
+        NULL
+};
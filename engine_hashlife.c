@@ -0,0 +1,486 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * HashLife: the world is a quadtree whose nodes are hash-consed, so that every distinct
+ * square of cells exists only once. The successor of a node of level L (its centre half
+ * advanced by up to 2^(L-2) generations) is memoised in the node itself, which lets
+ * repetitive patterns advance by astronomically many generations at once.
+ *
+ * Level 0 nodes are single cells; nodes 0 and 1 are the dead and the live cell.
+ * The root is always centred on the origin.
+ */
+
+#define NONE UINT32_MAX
+#define DEAD 0
+#define ALIVE 1
+#define MAX_LEVEL 62
+#define DEFAULT_BUDGET ((uint64_t) 512 << 20)
+
+typedef uint32_t NodeId;
+
+typedef struct Node {
+    NodeId nw, ne, sw, se;
+    NodeId next;            // hash chain, or free list if the node is unused
+    NodeId result;          // memoised successor or NONE
+    uint8_t level;
+    uint8_t resultExp;      // the successor is 2^resultExp generations ahead
+    bool mark;
+    uint64_t population;
+} Node;
+
+typedef struct HashLifeWorld {
+    Node *nodes;
+    uint32_t len, cap;
+    uint32_t freeCount;
+    NodeId freeList;
+    NodeId *buckets;
+    uint64_t bucketCap;     // always a power of two
+    int bucketShift;
+    NodeId empty[MAX_LEVEL + 2];
+    NodeId root;
+    uint64_t budget;
+    uint8_t successors[1 << 16];    // next state of the centre 2x2 of every 4x4 block, see baseSuccessor()
+} HashLifeWorld;
+
+#define N(id) (w->nodes[id])
+
+
+static void outOfMemory(void) {
+    fprintf(stderr, "HashLife engine ran out of memory.\n");
+    abort();
+}
+
+
+static uint64_t hashChildren(const HashLifeWorld *w, NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    uint64_t h = nw * 0x9E3779B97F4A7C15u;
+    h ^= ne * 0xC2B2AE3D27D4EB4Fu;
+    h ^= sw * 0x165667B19E3779F9u;
+    h ^= se * 0x27D4EB2F165667C5u;
+    return (h ^ h >> 29) * 0xBF58476D1CE4E5B9u >> w->bucketShift;
+}
+
+
+static void rehash(HashLifeWorld *w, uint64_t bucketCap) {
+    if (bucketCap != w->bucketCap) {
+        NodeId *buckets = heap_malloc(bucketCap * sizeof *buckets);
+        if (!buckets) outOfMemory();
+        free(w->buckets);
+        w->buckets = buckets;
+        w->bucketCap = bucketCap;
+        w->bucketShift = 64 - __builtin_ctzll(bucketCap);
+    }
+
+    memset(w->buckets, 0xFF, w->bucketCap * sizeof *w->buckets);
+    for (NodeId id = ALIVE + 1; id < w->len; ++id) {
+        Node *n = &N(id);
+        if (n->level == 0)
+            continue;   // unused
+        uint64_t h = hashChildren(w, n->nw, n->ne, n->sw, n->se);
+        n->next = w->buckets[h];
+        w->buckets[h] = id;
+    }
+}
+
+
+static NodeId allocNode(HashLifeWorld *w) {
+    if (w->freeList != NONE) {
+        NodeId id = w->freeList;
+        w->freeList = N(id).next;
+        --w->freeCount;
+        return id;
+    }
+
+    if (w->len == NONE)
+        outOfMemory();
+    if (w->len >= w->cap) {
+        uint32_t cap = w->cap > NONE / 2 ? NONE : w->cap * 2;
+        Node *nodes = heap_realloc(w->nodes, (uint64_t) cap * sizeof *nodes);
+        if (!nodes) outOfMemory();
+        w->nodes = nodes;
+        w->cap = cap;
+    }
+    return w->len++;
+}
+
+
+// return the canonical node with the given children
+static NodeId findNode(HashLifeWorld *w, NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    uint64_t h = hashChildren(w, nw, ne, sw, se);
+    for (NodeId id = w->buckets[h]; id != NONE; id = N(id).next) {
+        const Node *n = &N(id);
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se)
+            return id;
+    }
+
+    NodeId id = allocNode(w);
+    Node *n = &N(id);
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->result = NONE;
+    n->resultExp = 0;
+    n->mark = false;
+    n->level = N(nw).level + 1;
+    n->population = N(nw).population + N(ne).population + N(sw).population + N(se).population;
+    n->next = w->buckets[h];
+    w->buckets[h] = id;
+
+    if (w->len - w->freeCount > w->bucketCap)
+        rehash(w, w->bucketCap * 2);
+    return id;
+}
+
+
+static NodeId emptyNode(HashLifeWorld *w, int level) {
+    for (int l = 1; l <= level; ++l) {
+        if (w->empty[l] == NONE) {
+            const NodeId e = w->empty[l - 1];
+            w->empty[l] = findNode(w, e, e, e, e);
+        }
+    }
+    return w->empty[level];
+}
+
+
+static NodeId centre(HashLifeWorld *w, NodeId id) {
+    return findNode(w, N(N(id).nw).se, N(N(id).ne).sw, N(N(id).sw).ne, N(N(id).se).nw);
+}
+
+
+/*
+ * Base case: a level 2 node is a 4x4 block. Bit (y * 4 + x) of the index holds cell (x, y);
+ * the table entry holds the next state of the centre cells (1, 1), (2, 1), (1, 2), (2, 2) in bits 0 to 3.
+ */
+static void buildSuccessorTable(HashLifeWorld *w, const Rules *rules) {
+    for (uint32_t block = 0; block < 1 << 16; ++block) {
+        uint8_t result = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int cx = 1 + (i & 1), cy = 1 + (i >> 1);
+            uint16_t neighbourhood = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if ((block >> ((cy + dy) * 4 + cx + dx)) & 1)
+                        neighbourhood |= RULES_BIT(dx, dy);
+                }
+            }
+            if (neighbourhood && rules_next(rules, neighbourhood))
+                result |= 1 << i;
+        }
+        w->successors[block] = result;
+    }
+}
+
+
+static NodeId baseSuccessor(HashLifeWorld *w, NodeId id) {
+    const NodeId quads[4] = {N(id).nw, N(id).ne, N(id).sw, N(id).se};
+    uint32_t block = 0;
+    for (int q = 0; q < 4; ++q) {
+        const int ox = (q & 1) * 2, oy = (q >> 1) * 2;
+        const Node *n = &N(quads[q]);
+        block |= (uint32_t) (n->nw == ALIVE) << (oy * 4 + ox);
+        block |= (uint32_t) (n->ne == ALIVE) << (oy * 4 + ox + 1);
+        block |= (uint32_t) (n->sw == ALIVE) << ((oy + 1) * 4 + ox);
+        block |= (uint32_t) (n->se == ALIVE) << ((oy + 1) * 4 + ox + 1);
+    }
+
+    const uint8_t r = w->successors[block];
+    return findNode(w, r & 1, (r >> 1) & 1, (r >> 2) & 1, (r >> 3) & 1);
+}
+
+
+/*
+ * The centre half of node id, 2^k generations ahead. PRE-CONDITION: k <= level - 2.
+ * If k is less than that, the first half of the recursion only recentres without advancing.
+ */
+static NodeId successor(HashLifeWorld *w, NodeId id, int k) {
+    const int level = N(id).level;
+    if (N(id).population == 0)
+        return emptyNode(w, level - 1);
+    if (N(id).result != NONE && N(id).resultExp == k)
+        return N(id).result;
+
+    NodeId result;
+    if (level == 2) {
+        result = baseSuccessor(w, id);
+    } else {
+        const NodeId nw = N(id).nw, ne = N(id).ne, sw = N(id).sw, se = N(id).se;
+        NodeId n[3][3] = {
+                {nw, findNode(w, N(nw).ne, N(ne).nw, N(nw).se, N(ne).sw), ne},
+                {findNode(w, N(nw).sw, N(nw).se, N(sw).nw, N(sw).ne), centre(w, id),
+                 findNode(w, N(ne).sw, N(ne).se, N(se).nw, N(se).ne)},
+                {sw, findNode(w, N(sw).ne, N(se).nw, N(sw).se, N(se).sw), se}
+        };
+
+        const bool fullSpeed = k == level - 2;
+        for (int y = 0; y < 3; ++y) {
+            for (int x = 0; x < 3; ++x)
+                n[y][x] = fullSpeed ? successor(w, n[y][x], k - 1) : centre(w, n[y][x]);
+        }
+
+        const int k2 = fullSpeed ? k - 1 : k;
+        const NodeId rnw = successor(w, findNode(w, n[0][0], n[0][1], n[1][0], n[1][1]), k2);
+        const NodeId rne = successor(w, findNode(w, n[0][1], n[0][2], n[1][1], n[1][2]), k2);
+        const NodeId rsw = successor(w, findNode(w, n[1][0], n[1][1], n[2][0], n[2][1]), k2);
+        const NodeId rse = successor(w, findNode(w, n[1][1], n[1][2], n[2][1], n[2][2]), k2);
+        result = findNode(w, rnw, rne, rsw, rse);
+    }
+
+    N(id).result = result;
+    N(id).resultExp = (uint8_t) k;
+    return result;
+}
+
+
+// double the size of the universe, keeping the pattern centred
+static void expand(HashLifeWorld *w) {
+    const NodeId root = w->root;
+    const NodeId e = emptyNode(w, N(root).level - 1);
+    const NodeId nw = findNode(w, e, e, e, N(root).nw);
+    const NodeId ne = findNode(w, e, e, N(root).ne, e);
+    const NodeId sw = findNode(w, e, N(root).sw, e, e);
+    const NodeId se = findNode(w, N(root).se, e, e, e);
+    w->root = findNode(w, nw, ne, sw, se);
+}
+
+
+static void markNode(HashLifeWorld *w, NodeId id, bool keepResults) {
+    while (!N(id).mark) {
+        N(id).mark = true;
+        if (N(id).level == 0)
+            return;
+        markNode(w, N(id).nw, keepResults);
+        markNode(w, N(id).ne, keepResults);
+        markNode(w, N(id).sw, keepResults);
+        if (keepResults && N(id).result != NONE)
+            markNode(w, N(id).result, keepResults);
+        id = N(id).se;
+    }
+}
+
+
+// free every node not reachable from the root; memoised results are kept if keepResults is set
+static void collectGarbage(HashLifeWorld *w, bool keepResults) {
+    for (NodeId id = 0; id < w->len; ++id) {
+        N(id).mark = false;
+        if (!keepResults)
+            N(id).result = NONE;
+    }
+
+    N(DEAD).mark = N(ALIVE).mark = true;
+    markNode(w, w->root, keepResults);
+
+    w->freeList = NONE;
+    w->freeCount = 0;
+    for (NodeId id = w->len - 1; id > ALIVE; --id) {
+        Node *n = &N(id);
+        if (n->mark && n->level != 0) {
+            if (n->result != NONE && !N(n->result).mark)
+                n->result = NONE;
+            continue;
+        }
+        n->level = 0;
+        n->result = NONE;
+        n->next = w->freeList;
+        w->freeList = id;
+        ++w->freeCount;
+    }
+
+    for (int level = 1; level <= MAX_LEVEL + 1; ++level)
+        w->empty[level] = NONE;
+    rehash(w, w->bucketCap);
+}
+
+
+static uint64_t memoryUsed(const HashLifeWorld *w) {
+    return (uint64_t) (w->len - w->freeCount) * sizeof(Node) + w->bucketCap * sizeof(NodeId);
+}
+
+
+static void enforceBudget(HashLifeWorld *w) {
+    if (memoryUsed(w) <= w->budget)
+        return;
+    collectGarbage(w, true);
+    if (memoryUsed(w) > w->budget / 4 * 3)
+        collectGarbage(w, false);
+}
+
+
+// advance the universe by 2^k generations
+static void advance(HashLifeWorld *w, int k) {
+    enforceBudget(w);
+
+    // information travels one cell per generation, so the pattern must fit into the centre quarter
+    while (N(w->root).level < k + 3 || N(centre(w, centre(w, w->root))).population != N(w->root).population)
+        expand(w);
+    w->root = successor(w, w->root, k);
+}
+
+
+static NodeId setCellRec(HashLifeWorld *w, NodeId id, int64_t x, int64_t y, bool alive) {
+    const int level = N(id).level;
+    if (level == 0)
+        return alive ? ALIVE : DEAD;
+
+    // coordinates are relative to the centre of the node
+    const int64_t quarter = level == 1 ? 0 : (int64_t) 1 << (level - 2);
+    NodeId nw = N(id).nw, ne = N(id).ne, sw = N(id).sw, se = N(id).se;
+    if (level == 1) {
+        NodeId *leaf = y < 0 ? (x < 0 ? &nw : &ne) : (x < 0 ? &sw : &se);
+        *leaf = alive ? ALIVE : DEAD;
+    } else if (y < 0) {
+        if (x < 0) nw = setCellRec(w, nw, x + quarter, y + quarter, alive);
+        else       ne = setCellRec(w, ne, x - quarter, y + quarter, alive);
+    } else {
+        if (x < 0) sw = setCellRec(w, sw, x + quarter, y - quarter, alive);
+        else       se = setCellRec(w, se, x - quarter, y - quarter, alive);
+    }
+    return findNode(w, nw, ne, sw, se);
+}
+
+
+static void forEachRec(HashLifeWorld *w, NodeId id, int64_t x0, int64_t y0, const CellRect *r,
+                       void (*f)(Cell, void *), void *arg) {
+    const Node *n = &N(id);
+    const int64_t size = (int64_t) 1 << n->level;
+    if (n->population == 0 || x0 > r->x1 || y0 > r->y1 || x0 + size - 1 < r->x0 || y0 + size - 1 < r->y0)
+        return;
+
+    if (n->level == 0) {
+        f(cell_make((int32_t) x0, (int32_t) y0), arg);
+        return;
+    }
+
+    const int64_t half = size / 2;
+    const NodeId nw = n->nw, ne = n->ne, sw = n->sw, se = n->se;
+    forEachRec(w, nw, x0, y0, r, f, arg);
+    forEachRec(w, ne, x0 + half, y0, r, f, arg);
+    forEachRec(w, sw, x0, y0 + half, r, f, arg);
+    forEachRec(w, se, x0 + half, y0 + half, r, f, arg);
+}
+
+
+static void *create(const EngineConfig *config) {
+    HashLifeWorld *w = heap_calloc(1, sizeof *w);
+    if (!w) return NULL;
+
+    w->cap = 1 << 16;
+    w->nodes = heap_malloc(w->cap * sizeof *w->nodes);
+    if (!w->nodes) {
+        free(w);
+        return NULL;
+    }
+
+    w->budget = config->memoryBudget ? config->memoryBudget : DEFAULT_BUDGET;
+    w->freeList = NONE;
+    w->nodes[DEAD] = (Node) {.result = NONE, .population = 0};
+    w->nodes[ALIVE] = (Node) {.result = NONE, .population = 1};
+    w->len = 2;
+    for (int level = 0; level <= MAX_LEVEL + 1; ++level)
+        w->empty[level] = NONE;
+    w->empty[0] = DEAD;
+    rehash(w, 1 << 16);
+
+    buildSuccessorTable(w, &config->rules);
+    w->root = emptyNode(w, 3);
+    return w;
+}
+
+
+static void destroy(void *world) {
+    HashLifeWorld *w = world;
+    free(w->nodes);
+    free(w->buckets);
+    free(w);
+}
+
+
+static void step(void *world) {
+    advance(world, 0);
+}
+
+
+static uint64_t jump(void *world, uint64_t gens) {
+    if (gens == 0)
+        return 0;
+
+    int k = 63 - __builtin_clzll(gens);
+    if (k > MAX_LEVEL - 3)
+        k = MAX_LEVEL - 3;
+    advance(world, k);
+    return (uint64_t) 1 << k;
+}
+
+
+static void setCell(void *world, Cell c, bool alive) {
+    HashLifeWorld *w = world;
+    const int64_t x = cell_x(c), y = cell_y(c);
+    for (;;) {
+        const int64_t half = (int64_t) 1 << (N(w->root).level - 1);
+        if (-half <= x && x < half && -half <= y && y < half)
+            break;
+        expand(w);
+    }
+    w->root = setCellRec(w, w->root, x, y, alive);
+}
+
+
+static void load(void *world, const cellset *cells) {
+    for (uint64_t i = 0; i < cells->len; ++i)
+        setCell(world, cells->cells[i], true);
+    enforceBudget(world);
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    HashLifeWorld *w = world;
+    const int64_t half = (int64_t) 1 << (N(w->root).level - 1);
+    forEachRec(w, w->root, -half, -half, r, f, arg);
+}
+
+
+static uint64_t population(void *world) {
+    HashLifeWorld *w = world;
+    return N(w->root).population;
+}
+
+
+static void clear(void *world) {
+    HashLifeWorld *w = world;
+    w->root = emptyNode(w, 3);
+    collectGarbage(w, false);
+}
+
+
+static void setRules(void *world, const Rules *rules) {
+    HashLifeWorld *w = world;
+    buildSuccessorTable(w, rules);
+    collectGarbage(w, false);   // every memoised result follows the old rules
+}
+
+
+const struct GOL_Engine hashlifeEngine = {
+        "hashlife",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        jump,
+        NULL,
+        setRules,
+        NULL,
+        NULL,
+        NULL
+};
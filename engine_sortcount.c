@@ -0,0 +1,367 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "threadpool.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Sort-and-count engine: every live cell emits the keys of its eight neighbours and its own key,
+ * each tagged with the bit that the cell occupies in the neighbourhood of that key (rules.h), so
+ * the key of the cell itself carries RULES_CENTRE. An LSD radix sort brings equal keys together,
+ * and a run of equal keys ORs its tags into the complete neighbourhood of that cell, which is
+ * looked up in the rule table. Any rule works, not only outer totalistic ones.
+ *
+ * Every stage is a data-parallel pass over fixed chunks of the key buffer on the engine's thread
+ * pool: emitting, a digit histogram and a stable scatter per radix pass, counting, and gathering
+ * the cells of the next generation. Nothing is shared between the tasks of a pass, and the
+ * sort only runs the passes of the bytes in which the keys of a generation differ, which are
+ * four for a pattern within 65536 cells square.
+ *
+ * The next generation comes out sorted and free of duplicates; edits append to it until it is read
+ * or stepped again.
+ * The world hash is updated from the births and deaths found while counting.
+ */
+
+#define CHUNK_CELLS 8192                    // live cells emitting the keys of a chunk
+#define CHUNK_KEYS (9 * CHUNK_CELLS)        // keys per task of the parallel passes
+#define RADIX 256
+
+typedef struct Chunk {
+    uint64_t histogram[RADIX];  // keys per digit, then where in the other buffer the first of them goes
+    uint64_t varying;           // bits in which the emitted keys differ from the first live cell
+    uint64_t cells;             // cells of the next generation counted in the chunk
+    uint64_t hash;              // hash of the changes or, if the world hash is invalid, of the cells
+} Chunk;
+
+typedef struct SortCountWorld {
+    cellset *live;          // unsorted after edits; cells placed twice are only removed by deduplicate() or the next step
+    Cell *keys[2];          // keys[src] holds the keys of the current pass, the other one receives them
+    uint16_t *tags[2];      // neighbourhood bit of each key
+    uint64_t cap;           // keys held by each buffer
+    Chunk *chunks;
+    uint64_t chunkCap;
+    threadpool *pool;
+    Rules rules;
+    uint64_t hash;
+    bool hashValid;         // false after edits until duplicates are removed
+
+    // state of the current step, read by the tasks
+    uint64_t len;           // keys emitted
+    unsigned src;
+    unsigned shift;         // of the digit sorted by the current pass
+} SortCountWorld;
+
+
+static uint64_t minU64(uint64_t a, uint64_t b) {
+    return a < b ? a : b;
+}
+
+
+// grow the key buffers and chunks with some headroom; return true if out of memory
+static bool reserve(SortCountWorld *w, uint64_t keys) {
+    const uint64_t chunks = (keys + CHUNK_KEYS - 1) / CHUNK_KEYS;
+    if (chunks > w->chunkCap) {
+        Chunk *grown = heap_realloc(w->chunks, chunks * 2 * sizeof *grown);
+        if (!grown) return true;
+        w->chunks = grown;
+        w->chunkCap = chunks * 2;
+    }
+
+    if (keys <= w->cap)
+        return false;
+    const uint64_t cap = keys + keys / 2;
+    for (int i = 0; i < 2; ++i) {
+        Cell *k = heap_realloc(w->keys[i], cap * sizeof *k);
+        if (!k) return true;
+        w->keys[i] = k;
+        uint16_t *t = heap_realloc(w->tags[i], cap * sizeof *t);
+        if (!t) return true;
+        w->tags[i] = t;
+    }
+    w->cap = cap;
+    return false;
+}
+
+
+// emit the keys of a chunk of live cells into keys[0]
+static void emitTask(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    SortCountWorld *w = world;
+    const Cell *cells = w->live->cells;
+    const uint64_t begin = task * CHUNK_CELLS, end = minU64(begin + CHUNK_CELLS, w->live->len);
+    Cell *keys = w->keys[0] + begin * 9;
+    uint16_t *tags = w->tags[0] + begin * 9;
+    const Cell first = cells[0];
+    uint64_t varying = 0;
+
+    for (uint64_t i = begin; i < end; ++i) {
+        for (int64_t offsetX = -1; offsetX <= +1; ++offsetX) {
+            for (int64_t offsetY = -1; offsetY <= +1; ++offsetY) {
+                // seen from the neighbour, this cell sits at the opposite offset
+                const Cell key = cells[i] + (Cell) offsetX * CELL_DX + (Cell) offsetY * CELL_DY;
+                *keys++ = key;
+                *tags++ = (uint16_t) RULES_BIT(-offsetX, -offsetY);
+                varying |= key ^ first;
+            }
+        }
+    }
+    w->chunks[task].varying = varying;
+}
+
+
+static void histogramTask(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    SortCountWorld *w = world;
+    Chunk *chunk = &w->chunks[task];
+    const Cell *keys = w->keys[w->src];
+    const uint64_t begin = task * CHUNK_KEYS, end = minU64(begin + CHUNK_KEYS, w->len);
+    memset(chunk->histogram, 0, sizeof chunk->histogram);
+    for (uint64_t i = begin; i < end; ++i)
+        ++chunk->histogram[keys[i] >> w->shift & (RADIX - 1)];
+}
+
+
+// move the keys of a chunk to the positions of their digit in the other buffer, keeping their order
+static void scatterTask(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    SortCountWorld *w = world;
+    uint64_t *positions = w->chunks[task].histogram;
+    const Cell *keys = w->keys[w->src];
+    const uint16_t *tags = w->tags[w->src];
+    Cell *toKeys = w->keys[!w->src];
+    uint16_t *toTags = w->tags[!w->src];
+    const uint64_t begin = task * CHUNK_KEYS, end = minU64(begin + CHUNK_KEYS, w->len);
+    for (uint64_t i = begin; i < end; ++i) {
+        const uint64_t to = positions[keys[i] >> w->shift & (RADIX - 1)]++;
+        toKeys[to] = keys[i];
+        toTags[to] = tags[i];
+    }
+}
+
+
+// sort keys[src] by the digit at shift
+static void radixPass(SortCountWorld *w, uint64_t chunks) {
+    tp_run(w->pool, chunks, histogramTask, w);
+    // the keys of a digit go after those of smaller digits and, within a digit, after those of earlier chunks
+    uint64_t position = 0;
+    for (unsigned digit = 0; digit < RADIX; ++digit) {
+        for (uint64_t i = 0; i < chunks; ++i) {
+            const uint64_t count = w->chunks[i].histogram[digit];
+            w->chunks[i].histogram[digit] = position;
+            position += count;
+        }
+    }
+    tp_run(w->pool, chunks, scatterTask, w);
+    w->src = !w->src;
+}
+
+
+// decide the cells of the runs of equal keys beginning in a chunk of the sorted keys; the cells of the
+// next generation are written to the other buffer at the beginning of the chunk, which has room for all of them
+static void countTask(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    SortCountWorld *w = world;
+    Chunk *chunk = &w->chunks[task];
+    const Cell *keys = w->keys[w->src];
+    const uint16_t *tags = w->tags[w->src];
+    Cell *out = w->keys[!w->src] + task * CHUNK_KEYS;
+    const uint64_t end = minU64((task + 1) * CHUNK_KEYS, w->len);
+    uint64_t i = task * CHUNK_KEYS;
+    // a run reaching into the chunk from the previous one belongs to that chunk
+    while (i && i < end && keys[i] == keys[i - 1])
+        ++i;
+
+    uint64_t cells = 0, hash = 0;
+    while (i < end) {
+        const Cell c = keys[i];
+        uint16_t neighbourhood = 0;
+        for (; i < w->len && keys[i] == c; ++i)
+            neighbourhood |= tags[i];
+
+        const bool alive = neighbourhood & RULES_CENTRE;
+        const bool next = rules_next(&w->rules, neighbourhood);
+        if (next)
+            out[cells++] = c;
+        if (w->hashValid ? next != alive : next)
+            hash ^= cell_hash(c);
+    }
+    chunk->cells = cells;
+    chunk->hash = hash;
+}
+
+
+// copy the cells counted in a chunk into the live cells, after those of earlier chunks
+static void gatherTask(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    SortCountWorld *w = world;
+    const Chunk *chunk = &w->chunks[task];
+    // the offset of the chunk was left in its histogram by step()
+    memcpy(w->live->cells + chunk->histogram[0], w->keys[!w->src] + task * CHUNK_KEYS, chunk->cells * sizeof(Cell));
+}
+
+
+// remove the duplicates edits may have left in the live cells and rebuild the hash from them
+static void deduplicate(SortCountWorld *w) {
+    if (w->hashValid)
+        return;
+    cs_unique(cs_sort(w->live));
+    w->hash = cs_hash(w->live);
+    w->hashValid = true;
+}
+
+
+static void *create(const EngineConfig *config) {
+    SortCountWorld *w = heap_calloc(1, sizeof *w);
+    if (!w) return NULL;
+    w->live = cs_new();
+    w->pool = tp_new(config->threads);
+    if (!w->live || !w->pool) {
+        cs_destroy(w->live);
+        tp_destroy(w->pool);
+        free(w);
+        return NULL;
+    }
+
+    w->rules = config->rules;
+    w->hashValid = true;
+    return w;
+}
+
+
+static void destroy(void *world) {
+    SortCountWorld *w = world;
+    cs_destroy(w->live);
+    for (int i = 0; i < 2; ++i) {
+        free(w->keys[i]);
+        free(w->tags[i]);
+    }
+    free(w->chunks);
+    tp_destroy(w->pool);
+    free(w);
+}
+
+
+static void step(void *world) {
+    SortCountWorld *w = world;
+    if (!w->live->len) {
+        w->hash = 0;
+        w->hashValid = true;
+        return;
+    }
+
+    w->len = w->live->len * 9;
+    if (reserve(w, w->len)) {
+        fprintf(stderr, "Sort-and-count engine ran out of memory.\n");
+        abort();
+    }
+    const uint64_t chunks = (w->len + CHUNK_KEYS - 1) / CHUNK_KEYS;
+    w->src = 0;
+    tp_run(w->pool, chunks, emitTask, w);
+
+    // bytes in which all keys agree are already sorted
+    uint64_t varying = 0;
+    for (uint64_t i = 0; i < chunks; ++i)
+        varying |= w->chunks[i].varying;
+    for (w->shift = 0; w->shift < 64; w->shift += 8) {
+        if (varying >> w->shift & (RADIX - 1))
+            radixPass(w, chunks);
+    }
+
+    tp_run(w->pool, chunks, countTask, w);
+    uint64_t cells = 0, hash = w->hashValid ? w->hash : 0;
+    for (uint64_t i = 0; i < chunks; ++i) {
+        w->chunks[i].histogram[0] = cells;
+        cells += w->chunks[i].cells;
+        hash ^= w->chunks[i].hash;
+    }
+    cs_clear(w->live);
+    if (cs_reserve(w->live, cells)) {
+        fprintf(stderr, "Sort-and-count engine ran out of memory.\n");
+        abort();
+    }
+    tp_run(w->pool, chunks, gatherTask, w);
+    w->live->len = cells;
+    w->hash = hash;
+    w->hashValid = true;
+}
+
+
+static void load(void *world, const cellset *cells) {
+    SortCountWorld *w = world;
+    cs_concat(w->live, cells);
+    w->hashValid = false;
+}
+
+
+static void setCell(void *world, Cell c, bool alive) {
+    SortCountWorld *w = world;
+    if (alive)
+        cs_push(w->live, c);
+    else
+        cs_remove(w->live, c);
+    w->hashValid = false;
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    SortCountWorld *w = world;
+    deduplicate(w);
+    for (uint64_t i = 0; i < w->live->len; ++i) {
+        Cell c = w->live->cells[i];
+        int32_t x = cell_x(c), y = cell_y(c);
+        if (r->x0 <= x && x <= r->x1 && r->y0 <= y && y <= r->y1)
+            f(c, arg);
+    }
+}
+
+
+static uint64_t population(void *world) {
+    SortCountWorld *w = world;
+    deduplicate(w);
+    return w->live->len;
+}
+
+
+static void clear(void *world) {
+    SortCountWorld *w = world;
+    cs_clear(w->live);
+    w->hash = 0;
+    w->hashValid = true;
+}
+
+
+static void setRules(void *world, const Rules *rules) {
+    SortCountWorld *w = world;
+    w->rules = *rules;
+}
+
+
+static uint64_t hash(void *world) {
+    SortCountWorld *w = world;
+    deduplicate(w);
+    return w->hash;
+}
+
+
+const struct GOL_Engine sortCountEngine = {
+        "sortcount",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        NULL,
+        hash,
+        setRules,
+        NULL,
+        NULL,
+        NULL
+};
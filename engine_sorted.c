@@ -0,0 +1,348 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "profile.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * The original engine: live cells are kept in a sorted cell set and every neighbour
+ * is looked up by binary search.
+ * The set is never sorted as a whole. Survivors and births are each found in order and merged
+ * in one linear pass; cells placed by edits are collected in a small delta set, which is sorted
+ * and merged in before the cells are read or stepped again.
+ * The world hash is updated from the births and deaths of every step and from edits as they
+ * are merged in.
+ * The buffers of a step are kept and swapped between generations, so once they have grown
+ * to fit the population a step allocates nothing.
+ *
+ * Most neighbours looked up are dead. A blocked Bloom filter of the live cells, rebuilt at the
+ * start of every step, answers those lookups with a single load before any binary search runs:
+ * each cell sets two bits within one 64-bit word of the filter.
+ */
+
+#define FILTER_BITS_PER_CELL 16     // lets through about 0.5 % of the lookups of dead cells
+typedef struct SortedWorld {
+    cellset *squares;       // sorted, free of duplicates
+    cellset *placed;        // cells placed since the last merge, in any order
+    cellset *next;          // scratch: survivors, then the squares of the previous generation
+    cellset *potentials;    // scratch: dead neighbours of live cells, then births
+    uint64_t *filter;       // blocked Bloom filter of the squares during a step
+    uint64_t filterWords;   // always a power of two
+    int filterShift;
+    Rules rules;
+    uint64_t hash;
+} SortedWorld;
+
+
+// the word of the filter holding a cell and the two bits the cell sets in it
+static uint64_t filterBits(const SortedWorld *w, Cell c, uint64_t *word) {
+    const uint64_t h = cell_hash(c);
+    *word = h >> w->filterShift;
+    return (uint64_t) 1 << (h & 63) | (uint64_t) 1 << (h >> 6 & 63);
+}
+
+
+// return false if the cell is certainly not alive
+static bool mayLive(const SortedWorld *w, Cell c) {
+    uint64_t word;
+    const uint64_t bits = filterBits(w, c, &word);
+    return (w->filter[word] & bits) == bits;
+}
+
+
+// fill the filter with the squares. Like the hash engine's table, it only shrinks once it is four times
+// too large, so that a population swinging around a power of two does not reallocate it every generation
+static void rebuildFilter(SortedWorld *w) {
+    uint64_t words = 64;
+    while (words * 64 < w->squares->len * FILTER_BITS_PER_CELL)
+        words <<= 1;
+    if (words > w->filterWords || words * 4 < w->filterWords) {
+        uint64_t *filter = heap_realloc(w->filter, words * sizeof *filter);
+        if (!filter) {
+            fprintf(stderr, "Sorted engine ran out of memory.\n");
+            abort();
+        }
+        w->filter = filter;
+        w->filterWords = words;
+        w->filterShift = 64 - __builtin_ctzll(words);
+    }
+
+    memset(w->filter, 0, w->filterWords * sizeof *w->filter);
+    for (uint64_t i = 0; i < w->squares->len; ++i) {
+        uint64_t word;
+        const uint64_t bits = filterBits(w, w->squares->cells[i], &word);
+        w->filter[word] |= bits;
+    }
+}
+
+
+// insertion sort the last n items into the set (obvious pre-condition: rest of set is sorted)
+static void insertionSortTail(cellset *s, int n) {
+    if (n <= 0)
+        return;
+
+    Cell *cells = s->cells;
+    for (uint64_t i = s->len - n; i < s->len; ++i) {
+        for (uint64_t j = i; j > 0; --j) {
+            if (cells[j] >= cells[j - 1])
+                break;
+            Cell tmp = cells[j];
+            cells[j] = cells[j - 1];
+            cells[j - 1] = tmp;
+        }
+    }
+}
+
+
+// return true if the cell survives
+static bool determineWorthy(SortedWorld *w, Cell s, cellset *survivors, cellset *potentials) {
+    int taillen = 0;
+    uint16_t neighbourhood = RULES_CENTRE;
+
+    for (int64_t offsetX = -1; offsetX <= +1; ++offsetX) {
+        for (int64_t offsetY = -1; offsetY <= +1; ++offsetY) {
+            if (offsetX == 0 && offsetY == 0)
+                continue;
+
+            Cell neighbour = s + (Cell) offsetX * CELL_DX + (Cell) offsetY * CELL_DY;
+            int64_t i = mayLive(w, neighbour) ? cs_find(w->squares, neighbour) : -1;
+            if (i != -1)
+                neighbourhood |= RULES_BIT(offsetX, offsetY);
+
+            if (i == -1 && cs_find(potentials, neighbour) == -1) {
+                cs_push(potentials, neighbour);
+                ++taillen;
+            }
+        }
+    }
+
+    // insertion sorting the last few items is HUGELY more efficient than
+    // calling cs_sort(potentials) every damn time this function is called (which is a lot!)
+    insertionSortTail(potentials, taillen);
+
+    bool survives = rules_next(&w->rules, neighbourhood);
+    if (survives)
+        cs_push(survivors, s);
+    return survives;
+}
+
+
+static bool determineSpawning(SortedWorld *w, Cell s) {
+    uint16_t neighbourhood = 0;
+
+    for (int64_t offsetX = -1; offsetX <= +1; ++offsetX) {
+        for (int64_t offsetY = -1; offsetY <= +1; ++offsetY) {
+            if (offsetX == 0 && offsetY == 0)
+                continue;
+
+            Cell ns = s + (Cell) offsetX * CELL_DX + (Cell) offsetY * CELL_DY;
+            if (mayLive(w, ns) && cs_find(w->squares, ns) != -1)
+                neighbourhood |= RULES_BIT(offsetX, offsetY);
+        }
+    }
+
+    return rules_next(&w->rules, neighbourhood);
+}
+
+
+// grow a scratch buffer with some headroom, so that a slowly growing population does not reallocate every step
+static void reserve(cellset *s, uint64_t size) {
+    if (size > s->cap)
+        cs_reserve(s, size + size / 2);
+}
+
+
+// merge the placed cells into the squares
+static void mergePlaced(SortedWorld *w) {
+    if (!w->placed->len)
+        return;
+
+    cs_unique(cs_sort(w->placed));
+    for (uint64_t i = 0; i < w->placed->len; ++i) {
+        if (cs_find(w->squares, w->placed->cells[i]) == -1)
+            w->hash ^= cell_hash(w->placed->cells[i]);
+    }
+
+    reserve(w->next, w->squares->len + w->placed->len);
+    cs_merge(w->next, w->squares, w->placed);
+    cellset *merged = w->next;
+    w->next = w->squares;
+    w->squares = merged;
+    cs_clear(w->placed);
+}
+
+
+static void destroy(void *world) {
+    SortedWorld *w = world;
+    cs_destroy(w->squares);
+    cs_destroy(w->placed);
+    cs_destroy(w->next);
+    cs_destroy(w->potentials);
+    free(w->filter);
+    free(w);
+}
+
+
+static void *create(const EngineConfig *config) {
+    SortedWorld *w = heap_malloc(sizeof *w);
+    if (!w) return NULL;
+    w->squares = cs_new();
+    w->placed = cs_new();
+    w->next = cs_new();
+    w->potentials = cs_new();
+    w->filter = NULL;
+    w->filterWords = 0;
+    w->filterShift = 64;
+    w->rules = config->rules;
+    w->hash = 0;
+    if (!w->squares || !w->placed || !w->next || !w->potentials) {
+        destroy(w);
+        return NULL;
+    }
+    return w;
+}
+
+
+static void step(void *world) {
+    SortedWorld *w = world;
+    // marks between the phases, recorded at the end
+    ProfileMark m[6];
+    prof_mark(&m[0]);
+    mergePlaced(w);
+    rebuildFilter(w);
+    prof_mark(&m[1]);
+    const uint64_t cells = w->squares->len;
+
+    cellset *potentials = cs_clear(w->potentials);
+    cellset *survivors = cs_clear(w->next);
+    reserve(survivors, cells);
+    for (uint64_t i = 0; i < cells; ++i) {
+        if (!determineWorthy(w, w->squares->cells[i], survivors, potentials))
+            w->hash ^= cell_hash(w->squares->cells[i]);
+    }
+
+    prof_mark(&m[2]);
+    // the lookups above search a set whose tail is not yet sorted and may let duplicates through
+    cs_unique(potentials);
+    prof_mark(&m[3]);
+
+    uint64_t births = 0;
+    for (uint64_t i = 0; i < potentials->len; ++i) {
+        if (determineSpawning(w, potentials->cells[i])) {
+            w->hash ^= cell_hash(potentials->cells[i]);
+            potentials->cells[births++] = potentials->cells[i];
+        }
+    }
+    potentials->len = births;
+    prof_mark(&m[4]);
+
+    // survivors and births are disjoint and each sorted; the current squares are no longer
+    // needed, so their buffer receives the next generation
+    cellset *next = w->squares;
+    reserve(next, survivors->len + births);
+    cs_merge(next, survivors, potentials);
+    w->squares = next;
+    prof_mark(&m[5]);
+
+    prof_record(PROF_PREPARE, &m[0], &m[1], cells);
+    prof_record(PROF_WORTHY, &m[1], &m[2], cells);
+    prof_record(PROF_UNIQUE, &m[2], &m[3], cells);
+    prof_record(PROF_SPAWNING, &m[3], &m[4], cells);
+    prof_record(PROF_EXTEND, &m[4], &m[5], cells);
+}
+
+
+static void load(void *world, const cellset *cells) {
+    SortedWorld *w = world;
+    cs_concat(w->placed, cells);
+}
+
+
+static void setCell(void *world, Cell c, bool alive) {
+    SortedWorld *w = world;
+    if (alive) {
+        cs_push(w->placed, c);
+        return;
+    }
+
+    mergePlaced(w);
+    const int64_t i = cs_find(w->squares, c);
+    if (i == -1)
+        return;
+    memmove(w->squares->cells + i, w->squares->cells + i + 1, (w->squares->len - i - 1) * sizeof(Cell));
+    --w->squares->len;
+    w->hash ^= cell_hash(c);
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    SortedWorld *w = world;
+    mergePlaced(w);
+    // cells are ordered by x, so the columns of the rectangle are a contiguous range
+    int64_t i = 0, hi = (int64_t) w->squares->len;
+    for (const Cell first = cell_make(r->x0, INT32_MIN); i < hi; ) {
+        const int64_t mid = i + (hi - i) / 2;
+        if (w->squares->cells[mid] < first) i = mid + 1;
+        else hi = mid;
+    }
+    for (; i < (int64_t) w->squares->len; ++i) {
+        Cell c = w->squares->cells[i];
+        int32_t x = cell_x(c), y = cell_y(c);
+        if (x > r->x1)
+            break;
+        if (r->y0 <= y && y <= r->y1)
+            f(c, arg);
+    }
+}
+
+
+static uint64_t population(void *world) {
+    SortedWorld *w = world;
+    mergePlaced(w);
+    return w->squares->len;
+}
+
+
+static void clear(void *world) {
+    SortedWorld *w = world;
+    cs_clear(w->squares);
+    cs_clear(w->placed);
+    w->hash = 0;
+}
+
+
+static void setRules(void *world, const Rules *rules) {
+    SortedWorld *w = world;
+    w->rules = *rules;
+}
+
+
+static uint64_t hash(void *world) {
+    SortedWorld *w = world;
+    mergePlaced(w);
+    return w->hash;
+}
+
+
+const struct GOL_Engine sortedEngine = {
+        "sorted",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        NULL,
+        hash,
+        setRules,
+        NULL,
+        NULL,
+        NULL
+};
@@ -0,0 +1,284 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Sweep-line engine: like the sorted engine it keeps the live cells in a sorted cell set, but
+ * it never searches it. Cells are ordered by column and then by row, so the next generation
+ * of column x only depends on the three runs of cells in columns x - 1, x and x + 1. A sweep
+ * moves one cursor through each of these runs in step, reading the neighbourhood of every row
+ * next to a live cell, and writes the cells of the next generation in order as it goes.
+ * A generation is a single pass over memory that only ever moves forwards, so it suits huge
+ * sparse patterns whose neighbours would otherwise be looked up all over the heap.
+ *
+ * Cells placed by edits are collected in a small delta set, which is sorted and merged in before
+ * the cells are read or stepped again; the world hash is kept up to date like in the sorted engine.
+ * Cells never leave the 32-bit world: neighbours beyond its edge are not born.
+ */
+typedef struct SweepWorld {
+    cellset *squares;       // sorted, free of duplicates
+    cellset *placed;        // cells placed since the last merge, in any order
+    cellset *next;          // scratch: the next generation, then the previous one
+    Rules rules;
+    uint64_t hash;
+} SweepWorld;
+
+// cells of a column not passed by the sweep yet; empty if at == end
+typedef struct Run {
+    uint64_t at, end;
+} Run;
+
+
+// column and row of a cell as unsigned offsets from the lowest coordinate, so that they can step past the edge
+static int64_t columnOf(Cell c) {
+    return (int64_t) (c >> 32);
+}
+
+
+static int64_t rowOf(Cell c) {
+    return (int64_t) (uint32_t) c;
+}
+
+
+// the run of column x starting at cell i, which is empty unless cell i lies in that column
+static Run runAt(const cellset *s, uint64_t i, int64_t x) {
+    Run r = {i, i};
+    while (r.end < s->len && columnOf(s->cells[r.end]) == x)
+        ++r.end;
+    return r;
+}
+
+
+// the rows y - 1, y and y + 1 of a run as three bits, rows below y - 1 having been passed before
+static unsigned rowBits(const Cell *cells, const Run *r, int64_t y) {
+    unsigned bits = 0;
+    for (uint64_t i = r->at; i < r->end && i < r->at + 3; ++i) {
+        const int64_t dy = rowOf(cells[i]) - y;
+        if (dy > 1)
+            break;
+        bits |= 1u << (dy + 1);
+    }
+    return bits;
+}
+
+
+// compute the next generation of column x from the runs of columns x - 1, x and x + 1
+static void sweepColumn(SweepWorld *w, int64_t x, Run left, Run centre, Run right) {
+    const Cell *cells = w->squares->cells;
+    Run *runs[3] = {&left, &centre, &right};
+    if (x < 0 || x > UINT32_MAX)
+        return;
+
+    for (int64_t y = -1; ; ++y) {
+        // pass the cells too far up to touch row y and skip ahead to the row above the nearest cell
+        int64_t nearest = INT64_MAX;
+        for (int i = 0; i < 3; ++i) {
+            Run *r = runs[i];
+            while (r->at < r->end && rowOf(cells[r->at]) < y - 1)
+                ++r->at;
+            if (r->at < r->end && rowOf(cells[r->at]) < nearest)
+                nearest = rowOf(cells[r->at]);
+        }
+        if (nearest == INT64_MAX)
+            return;
+        if (nearest - 1 > y)
+            y = nearest - 1;
+        if (y < 0 || y > UINT32_MAX)
+            continue;
+
+        // bit 3 * (dx + 1) + (dy + 1) holds the cell at (dx, dy), see rules.h
+        const uint16_t neighbourhood = (uint16_t) (rowBits(cells, &left, y)
+                | rowBits(cells, &centre, y) << 3 | rowBits(cells, &right, y) << 6);
+        const bool alive = neighbourhood & RULES_CENTRE;
+        const bool lives = rules_next(&w->rules, neighbourhood);
+        const Cell c = (Cell) x << 32 | (Cell) y;
+        if (lives)
+            cs_push(w->next, c);
+        if (lives != alive)
+            w->hash ^= cell_hash(c);
+    }
+}
+
+
+// grow a buffer with some headroom, so that a slowly growing population does not reallocate every merge
+static void reserve(cellset *s, uint64_t size) {
+    if (size > s->cap)
+        cs_reserve(s, size + size / 2);
+}
+
+
+// merge the placed cells into the squares
+static void mergePlaced(SweepWorld *w) {
+    if (!w->placed->len)
+        return;
+
+    cs_unique(cs_sort(w->placed));
+    for (uint64_t i = 0; i < w->placed->len; ++i) {
+        if (cs_find(w->squares, w->placed->cells[i]) == -1)
+            w->hash ^= cell_hash(w->placed->cells[i]);
+    }
+
+    reserve(w->next, w->squares->len + w->placed->len);
+    cs_merge(w->next, w->squares, w->placed);
+    cellset *merged = w->next;
+    w->next = w->squares;
+    w->squares = merged;
+    cs_clear(w->placed);
+}
+
+
+static void destroy(void *world) {
+    SweepWorld *w = world;
+    cs_destroy(w->squares);
+    cs_destroy(w->placed);
+    cs_destroy(w->next);
+    free(w);
+}
+
+
+static void *create(const EngineConfig *config) {
+    SweepWorld *w = heap_malloc(sizeof *w);
+    if (!w) return NULL;
+    w->squares = cs_new();
+    w->placed = cs_new();
+    w->next = cs_new();
+    w->rules = config->rules;
+    w->hash = 0;
+    if (!w->squares || !w->placed || !w->next) {
+        destroy(w);
+        return NULL;
+    }
+    return w;
+}
+
+
+static void step(void *world) {
+    SweepWorld *w = world;
+    mergePlaced(w);
+    const cellset *s = w->squares;
+    cs_clear(w->next);
+    if (!s->len)
+        return;
+
+    // the runs of columns x - 1, x and x + 1; ahead is the first cell of the columns beyond
+    int64_t x = columnOf(s->cells[0]) - 1;
+    Run left = {0, 0}, centre = {0, 0}, right = runAt(s, 0, x + 1);
+    uint64_t ahead = right.end;
+    for (;;) {
+        sweepColumn(w, x, left, centre, right);
+
+        ++x;
+        left = centre;
+        centre = right;
+        right = runAt(s, ahead, x + 1);
+        ahead = right.end;
+        // jump over empty columns to the one in front of the next live column
+        if (left.at == left.end && centre.at == centre.end && right.at == right.end) {
+            if (ahead == s->len)
+                break;
+            x = columnOf(s->cells[ahead]) - 1;
+            right = runAt(s, ahead, x + 1);
+            ahead = right.end;
+        }
+    }
+
+    cellset *next = w->next;
+    w->next = w->squares;
+    w->squares = next;
+}
+
+
+static void load(void *world, const cellset *cells) {
+    SweepWorld *w = world;
+    cs_concat(w->placed, cells);
+}
+
+
+static void setCell(void *world, Cell c, bool alive) {
+    SweepWorld *w = world;
+    if (alive) {
+        cs_push(w->placed, c);
+        return;
+    }
+
+    mergePlaced(w);
+    const int64_t i = cs_find(w->squares, c);
+    if (i == -1)
+        return;
+    memmove(w->squares->cells + i, w->squares->cells + i + 1, (w->squares->len - i - 1) * sizeof(Cell));
+    --w->squares->len;
+    w->hash ^= cell_hash(c);
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    SweepWorld *w = world;
+    mergePlaced(w);
+    // cells are ordered by x, so the columns of the rectangle are a contiguous range
+    int64_t i = 0, hi = (int64_t) w->squares->len;
+    for (const Cell first = cell_make(r->x0, INT32_MIN); i < hi; ) {
+        const int64_t mid = i + (hi - i) / 2;
+        if (w->squares->cells[mid] < first) i = mid + 1;
+        else hi = mid;
+    }
+    for (; i < (int64_t) w->squares->len; ++i) {
+        Cell c = w->squares->cells[i];
+        int32_t x = cell_x(c), y = cell_y(c);
+        if (x > r->x1)
+            break;
+        if (r->y0 <= y && y <= r->y1)
+            f(c, arg);
+    }
+}
+
+
+static uint64_t population(void *world) {
+    SweepWorld *w = world;
+    mergePlaced(w);
+    return w->squares->len;
+}
+
+
+static void clear(void *world) {
+    SweepWorld *w = world;
+    cs_clear(w->squares);
+    cs_clear(w->placed);
+    w->hash = 0;
+}
+
+
+static void setRules(void *world, const Rules *rules) {
+    SweepWorld *w = world;
+    w->rules = *rules;
+}
+
+
+static uint64_t hash(void *world) {
+    SweepWorld *w = world;
+    mergePlaced(w);
+    return w->hash;
+}
+
+
+const struct GOL_Engine sweepEngine = {
+        "sweep",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        NULL,
+        hash,
+        setRules,
+        NULL,
+        NULL,
+        NULL
+};
@@ -0,0 +1,709 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "engine.h"
+#include "tilekernel.h"
+#include "threadpool.h"
+#include "arena.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Dense engine: the world is a sparse map of 64x64 tiles, each tile a bitboard of 64 rows.
+ * Bit i of a row is the cell at x offset i within the tile. A generation is computed for
+ * 64 cells at once per row with bit-sliced full adders; the rows and columns directly
+ * bordering a tile are fetched from its neighbours (the halo). Tiles are stepped in parallel
+ * in blocks of TILES_PER_TASK on the engine's thread pool.
+ *
+ * Only active tiles are stepped. A tile is quiet if its current generation equals the one two
+ * generations back; if a tile and all its neighbours are quiet, its next generation equals its
+ * previous one, which is still in the other buffer, so the tile is skipped and the phase flip
+ * alone advances it. Still lifes and period-2 oscillators cost nothing until a neighbour changes.
+ * To keep this sound, a missing tile must behave like a quiet one: tiles are only dropped after
+ * being empty for three generations and never while a neighbour's live edge borders them.
+ * An edit or new rules leave the other buffer without the generation before the current one,
+ * so such a tile is never considered quiet right after its next step.
+ *
+ * The world hash is kept per buffer: a stepped tile adds the hashes of the cells that differ
+ * from the current generation, a skipped tile already carries the hash of its other buffer.
+ *
+ * Outer totalistic rules use the counting kernels; other rules fall back to a table lookup per cell.
+ *
+ * Tiles and their age planes come from a slab arena: the tiles dropped and claimed again as a pattern
+ * moves are recycled through its free lists, and clearing the world releases all of them at once.
+ *
+ * Generations rules keep the age of dying cells (state - 1) in bit-planes next to the live rows,
+ * so all dying cells of a row age in a few bitwise operations. Dying cells never reach beyond
+ * their tile, hence the halo and edges only concern live cells.
+ */
+
+#define EMPTY_SLOT UINT64_MAX
+#define TILES_PER_TASK 16
+#define MAX_PLANES 8    // enough for the age of RULES_MAX_STATES - 1
+
+enum {
+    EDGE_N = 1, EDGE_S = 2, EDGE_W = 4, EDGE_E = 8,
+    EDGE_NW = 16, EDGE_NE = 32, EDGE_SW = 64, EDGE_SE = 128
+};
+
+typedef struct Tile {
+    int32_t tx, ty;
+    uint64_t rows[2][TILE_SIZE];    // current generation is rows[phase]
+    uint64_t *planes;               // Generations rules only: age bit-planes of both buffers, see agesOf()
+    uint8_t edges[2];               // EDGE_* flags of the borders of rows[i] holding live cells
+    bool empty[2];                  // buffer i holds no live or dying cell
+    bool quiet;                     // rows[phase] equals the generation two steps back
+    bool changed;                   // stepped or edited since the halo was last extended
+    bool stale;                     // rows[!phase] is no generation before rows[phase] after an edit or new rules
+    bool dropped;                   // about to be freed
+    uint64_t scheduled;             // step count at which the tile was last made active
+    uint64_t hash[2];               // world hash of the cells in rows[i]
+    uint64_t hashChange;            // change of hash[!phase] in the current step
+} Tile;
+
+typedef struct TileWorld {
+    Tile **tiles;
+    uint64_t len, cap;
+    Cell *mapKeys;          // tile coordinates packed like cells
+    uint32_t *mapTiles;     // index into tiles
+    uint64_t mapCap;        // always a power of two
+    int mapShift;
+    Tile **active;          // tiles to step in the current generation
+    uint64_t activeLen, activeCap;
+    uint64_t steps;
+    uint64_t hash[2];       // XOR of the hash[i] of all tiles
+    int phase;
+    Rules rules;
+    bool totalistic;        // the kernel can be used instead of rules
+    uint16_t birth;         // bit n set if n neighbours give birth
+    uint16_t survival;      // bit n set if n neighbours sustain a cell
+    int planeCount;         // age bit-planes of dying cells; 0 for two-state rules
+    TileKernel kernel;
+    threadpool *pool;
+    arena *arena;           // tiles and their age planes
+} TileWorld;
+
+
+static Cell tileKey(int32_t tx, int32_t ty) {
+    return cell_make(tx, ty);
+}
+
+
+static uint64_t slotOf(const TileWorld *w, Cell key) {
+    return (key * 0x9E3779B97F4A7C15u) >> w->mapShift;
+}
+
+
+static uint64_t findSlot(const TileWorld *w, Cell key) {
+    const uint64_t mask = w->mapCap - 1;
+    uint64_t i = slotOf(w, key);
+    while (w->mapKeys[i] != key && w->mapKeys[i] != EMPTY_SLOT)
+        i = (i + 1) & mask;
+    return i;
+}
+
+
+static Tile *findTile(const TileWorld *w, int32_t tx, int32_t ty) {
+    uint64_t i = findSlot(w, tileKey(tx, ty));
+    return w->mapKeys[i] == EMPTY_SLOT ? NULL : w->tiles[w->mapTiles[i]];
+}
+
+
+static void outOfMemory(void) {
+    fprintf(stderr, "Tile engine ran out of memory.\n");
+    abort();
+}
+
+
+// age bit-planes of buffer b; plane p of row i is at index p * TILE_SIZE + i. NULL for two-state rules
+static uint64_t *agesOf(const TileWorld *w, const Tile *t, int b) {
+    return t->planes ? t->planes + (size_t) b * w->planeCount * TILE_SIZE : NULL;
+}
+
+
+static size_t planesSize(const TileWorld *w) {
+    return (size_t) 2 * w->planeCount * TILE_SIZE * sizeof(uint64_t);
+}
+
+
+// the planes of every tile have the size for the current planeCount
+static void allocPlanes(const TileWorld *w, Tile *t) {
+    if (w->planeCount) {
+        t->planes = ar_calloc(w->arena, planesSize(w));
+        if (!t->planes) outOfMemory();
+    }
+}
+
+
+static void freeTile(const TileWorld *w, Tile *t) {
+    ar_free(w->arena, t->planes, planesSize(w));
+    ar_free(w->arena, t, sizeof *t);
+}
+
+
+// state of cell x of row i given the live rows and age planes of one buffer
+static unsigned stateOf(const TileWorld *w, const uint64_t *rows, const uint64_t *ages, int i, int x) {
+    if ((rows[i] >> x) & 1)
+        return 1;
+    unsigned age = 0;
+    for (int p = 0; p < w->planeCount; ++p)
+        age |= (unsigned) ((ages[p * TILE_SIZE + i] >> x) & 1) << p;
+    return age ? age + 1 : 0;
+}
+
+
+// rebuild the map from the tile array with room for at least twice as many tiles
+static void rebuildMap(TileWorld *w) {
+    uint64_t cap = 64;
+    while (cap < w->len * 4)
+        cap <<= 1;
+
+    if (cap != w->mapCap) {
+        free(w->mapKeys);
+        free(w->mapTiles);
+        w->mapKeys = heap_malloc(cap * sizeof *w->mapKeys);
+        w->mapTiles = heap_malloc(cap * sizeof *w->mapTiles);
+        if (!w->mapKeys || !w->mapTiles)
+            outOfMemory();
+        w->mapCap = cap;
+        w->mapShift = 64 - __builtin_ctzll(cap);
+    }
+
+    memset(w->mapKeys, 0xFF, w->mapCap * sizeof *w->mapKeys);
+    for (uint64_t i = 0; i < w->len; ++i) {
+        Cell key = tileKey(w->tiles[i]->tx, w->tiles[i]->ty);
+        uint64_t slot = findSlot(w, key);
+        w->mapKeys[slot] = key;
+        w->mapTiles[slot] = (uint32_t) i;
+    }
+}
+
+
+static Tile *claimTile(TileWorld *w, int32_t tx, int32_t ty) {
+    Tile *t = findTile(w, tx, ty);
+    if (t) return t;
+
+    if (w->len >= w->cap) {
+        uint64_t cap = (w->cap << 1) | 1;
+        Tile **tiles = heap_realloc(w->tiles, cap * sizeof *tiles);
+        if (!tiles) outOfMemory();
+        w->tiles = tiles;
+        w->cap = cap;
+    }
+
+    t = ar_calloc(w->arena, sizeof *t);
+    if (!t) outOfMemory();
+    t->tx = tx;
+    t->ty = ty;
+    allocPlanes(w, t);
+    t->empty[0] = t->empty[1] = true;
+    t->quiet = true;    // a missing tile has been empty for at least three generations
+    w->tiles[w->len++] = t;
+
+    if (w->len * 2 > w->mapCap) {
+        rebuildMap(w);
+    } else {
+        Cell key = tileKey(tx, ty);
+        uint64_t slot = findSlot(w, key);
+        w->mapKeys[slot] = key;
+        w->mapTiles[slot] = (uint32_t) (w->len - 1);
+    }
+
+    return t;
+}
+
+
+static uint8_t edgesOf(const uint64_t *rows) {
+    const uint64_t west = 1, east = (uint64_t) 1 << (TILE_SIZE - 1);
+    const uint64_t top = rows[0], bottom = rows[TILE_SIZE - 1];
+    uint64_t columns = 0;
+    for (int r = 0; r < TILE_SIZE; ++r)
+        columns |= rows[r];
+
+    return (uint8_t) ((top ? EDGE_N : 0) | (bottom ? EDGE_S : 0)
+                      | (columns & west ? EDGE_W : 0) | (columns & east ? EDGE_E : 0)
+                      | (top & west ? EDGE_NW : 0) | (top & east ? EDGE_NE : 0)
+                      | (bottom & west ? EDGE_SW : 0) | (bottom & east ? EDGE_SE : 0));
+}
+
+
+// recompute the cached summary of a buffer of a tile after it was written to
+static void summarise(const TileWorld *w, Tile *t, int phase) {
+    uint64_t any = 0;
+    for (int i = 0; i < TILE_SIZE; ++i)
+        any |= t->rows[phase][i];
+    t->edges[phase] = any ? edgesOf(t->rows[phase]) : 0;
+
+    const uint64_t *ages = agesOf(w, t, phase);
+    for (int i = 0; i < w->planeCount * TILE_SIZE; ++i)
+        any |= ages[i];
+    t->empty[phase] = !any;
+}
+
+
+// make sure every tile that could receive a birth from a live edge cell exists;
+// tiles that did not change still have their halo from before
+static void extendHalo(TileWorld *w) {
+    const uint64_t len = w->len;
+    for (uint64_t i = 0; i < len; ++i) {
+        Tile *t = w->tiles[i];
+        if (!t->changed)
+            continue;
+        t->changed = false;
+
+        const uint8_t edges = t->edges[w->phase];
+        const int32_t tx = t->tx, ty = t->ty;
+        if (edges & EDGE_N) claimTile(w, tx, ty - 1);
+        if (edges & EDGE_S) claimTile(w, tx, ty + 1);
+        if (edges & EDGE_W) claimTile(w, tx - 1, ty);
+        if (edges & EDGE_E) claimTile(w, tx + 1, ty);
+        if (edges & EDGE_NW) claimTile(w, tx - 1, ty - 1);
+        if (edges & EDGE_NE) claimTile(w, tx + 1, ty - 1);
+        if (edges & EDGE_SW) claimTile(w, tx - 1, ty + 1);
+        if (edges & EDGE_SE) claimTile(w, tx + 1, ty + 1);
+    }
+}
+
+
+static void schedule(TileWorld *w, Tile *t) {
+    if (!t || t->scheduled == w->steps)
+        return;
+    t->scheduled = w->steps;
+
+    if (w->activeLen >= w->activeCap) {
+        uint64_t cap = (w->activeCap << 1) | 1;
+        Tile **active = heap_realloc(w->active, cap * sizeof *active);
+        if (!active) outOfMemory();
+        w->active = active;
+        w->activeCap = cap;
+    }
+    w->active[w->activeLen++] = t;
+}
+
+
+// collect every tile that is not quiet or borders one that is not
+static void scheduleActive(TileWorld *w) {
+    ++w->steps;
+    w->activeLen = 0;
+
+    // in a busy world, looking up the neighbours costs more than stepping a few quiet tiles
+    uint64_t busy = 0;
+    for (uint64_t i = 0; i < w->len; ++i)
+        busy += !w->tiles[i]->quiet;
+    if (busy * 2 > w->len) {
+        for (uint64_t i = 0; i < w->len; ++i)
+            schedule(w, w->tiles[i]);
+        return;
+    }
+
+    for (uint64_t i = 0; i < w->len; ++i) {
+        Tile *t = w->tiles[i];
+        if (t->quiet)
+            continue;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx)
+                schedule(w, dx || dy ? findTile(w, t->tx + dx, t->ty + dy) : t);
+        }
+    }
+}
+
+
+// whether a live edge of a neighbour in either buffer borders the tile, in which case the tile must stay
+static bool bordered(const TileWorld *w, const Tile *t) {
+    static const struct {int dx, dy; uint8_t edge;} facing[8] = {
+            {0, -1, EDGE_S}, {0, 1, EDGE_N}, {-1, 0, EDGE_E}, {1, 0, EDGE_W},
+            {-1, -1, EDGE_SE}, {1, -1, EDGE_SW}, {-1, 1, EDGE_NE}, {1, 1, EDGE_NW}
+    };
+
+    for (int i = 0; i < 8; ++i) {
+        const Tile *n = findTile(w, t->tx + facing[i].dx, t->ty + facing[i].dy);
+        if (n && (n->edges[0] | n->edges[1]) & facing[i].edge)
+            return true;
+    }
+    return false;
+}
+
+
+// age the dying cells of a tile by one generation and let the cells that just died start dying;
+// dying cells cannot be born, so they are removed from out
+static void decay(const TileWorld *w, const Tile *t, uint64_t *out, uint64_t *next) {
+    const uint64_t *ages = agesOf(w, t, w->phase);
+    const unsigned expiry = w->rules.states - 1;    // the age at which a cell is dead again
+
+    for (int i = 0; i < TILE_SIZE; ++i) {
+        uint64_t dying = 0;
+        for (int p = 0; p < w->planeCount; ++p)
+            dying |= ages[p * TILE_SIZE + i];
+
+        // bit-sliced increment of the age of every dying cell
+        uint64_t carry = dying, expired = dying;
+        for (int p = 0; p < w->planeCount; ++p) {
+            const uint64_t age = ages[p * TILE_SIZE + i];
+            next[p * TILE_SIZE + i] = age ^ carry;
+            carry &= age;
+            expired &= (expiry >> p) & 1 ? next[p * TILE_SIZE + i] : ~next[p * TILE_SIZE + i];
+        }
+        for (int p = 0; p < w->planeCount; ++p)
+            next[p * TILE_SIZE + i] &= ~expired;
+
+        out[i] &= ~dying;
+        next[i] |= t->rows[w->phase][i] & ~out[i];
+    }
+}
+
+
+static void stepTile(TileWorld *w, Tile *t) {
+    const int cur = w->phase;
+    const Tile *n = findTile(w, t->tx, t->ty - 1);
+    const Tile *s = findTile(w, t->tx, t->ty + 1);
+    const Tile *west = findTile(w, t->tx - 1, t->ty);
+    const Tile *east = findTile(w, t->tx + 1, t->ty);
+    const Tile *nw = findTile(w, t->tx - 1, t->ty - 1);
+    const Tile *ne = findTile(w, t->tx + 1, t->ty - 1);
+    const Tile *sw = findTile(w, t->tx - 1, t->ty + 1);
+    const Tile *se = findTile(w, t->tx + 1, t->ty + 1);
+
+    uint64_t m[TILE_SIZE + 2], westCol[TILE_SIZE + 2], eastCol[TILE_SIZE + 2];
+    m[0] = n ? n->rows[cur][TILE_SIZE - 1] : 0;
+    m[TILE_SIZE + 1] = s ? s->rows[cur][0] : 0;
+    memcpy(m + 1, t->rows[cur], sizeof t->rows[cur]);
+
+    // the single cells west and east of every row, as bit 0 and bit 63 respectively
+    westCol[0] = nw ? nw->rows[cur][TILE_SIZE - 1] >> (TILE_SIZE - 1) : 0;
+    eastCol[0] = ne ? ne->rows[cur][TILE_SIZE - 1] << (TILE_SIZE - 1) : 0;
+    westCol[TILE_SIZE + 1] = sw ? sw->rows[cur][0] >> (TILE_SIZE - 1) : 0;
+    eastCol[TILE_SIZE + 1] = se ? se->rows[cur][0] << (TILE_SIZE - 1) : 0;
+    for (int i = 0; i < TILE_SIZE; ++i) {
+        westCol[i + 1] = west ? west->rows[cur][i] >> (TILE_SIZE - 1) : 0;
+        eastCol[i + 1] = east ? east->rows[cur][i] << (TILE_SIZE - 1) : 0;
+    }
+
+    uint64_t l[TILE_SIZE + 2], r[TILE_SIZE + 2];
+    for (int i = 0; i < TILE_SIZE + 2; ++i) {
+        l[i] = m[i] << 1 | westCol[i];
+        r[i] = m[i] >> 1 | eastCol[i];
+    }
+
+    uint64_t out[TILE_SIZE];
+    if (w->totalistic)
+        w->kernel(l, m, r, out, w->birth, w->survival);
+    else
+        tileKernel_lookup(l, m, r, out, &w->rules);
+
+    uint64_t ages[MAX_PLANES * TILE_SIZE];
+    const size_t agesSize = (size_t) w->planeCount * TILE_SIZE * sizeof *ages;
+    if (w->planeCount)
+        decay(w, t, out, ages);
+
+    // the other buffer still holds the previous generation, unless the tile was edited or the rules were changed since
+    t->quiet = !t->stale && !memcmp(out, t->rows[!cur], sizeof out)
+            && (!agesSize || !memcmp(ages, agesOf(w, t, !cur), agesSize));
+    t->stale = false;
+    t->hashChange = 0;
+    if (!t->quiet) {
+        const uint64_t *curAges = agesOf(w, t, cur);
+        uint64_t hash = t->hash[cur];
+        const int32_t x0 = (int32_t) ((uint32_t) t->tx << TILE_BITS), y0 = (int32_t) ((uint32_t) t->ty << TILE_BITS);
+        for (int i = 0; i < TILE_SIZE; ++i) {
+            uint64_t changed = out[i] ^ t->rows[cur][i];
+            for (int p = 0; p < w->planeCount; ++p)
+                changed |= ages[p * TILE_SIZE + i] ^ curAges[p * TILE_SIZE + i];
+
+            for (uint64_t bits = changed; bits; bits &= bits - 1) {
+                const int x = __builtin_ctzll(bits);
+                const Cell c = cell_make(x0 + x, y0 + i);
+                hash ^= cell_stateHash(c, stateOf(w, t->rows[cur], curAges, i, x)) ^ cell_stateHash(c, stateOf(w, out, ages, i, x));
+            }
+        }
+        t->hashChange = hash ^ t->hash[!cur];
+        t->hash[!cur] = hash;
+
+        memcpy(t->rows[!cur], out, sizeof out);
+        if (agesSize)
+            memcpy(agesOf(w, t, !cur), ages, agesSize);
+        summarise(w, t, !cur);
+        t->changed = true;
+    }
+}
+
+
+static void stepTask(uint64_t task, unsigned thread, void *world) {
+    (void) thread;
+    TileWorld *w = world;
+    const uint64_t end = (task + 1) * TILES_PER_TASK < w->activeLen ? (task + 1) * TILES_PER_TASK : w->activeLen;
+    for (uint64_t i = task * TILES_PER_TASK; i < end; ++i)
+        stepTile(w, w->active[i]);
+}
+
+
+// hash of the live cells of a buffer of a tile
+static uint64_t hashLiveCells(const Tile *t, int b) {
+    const int32_t x0 = (int32_t) ((uint32_t) t->tx << TILE_BITS), y0 = (int32_t) ((uint32_t) t->ty << TILE_BITS);
+    uint64_t hash = 0;
+    for (int i = 0; i < TILE_SIZE; ++i) {
+        for (uint64_t bits = t->rows[b][i]; bits; bits &= bits - 1)
+            hash ^= cell_hash(cell_make(x0 + __builtin_ctzll(bits), y0 + i));
+    }
+    return hash;
+}
+
+
+// changing the number of states drops all dying cells
+static void setRules(void *world, const Rules *rules) {
+    TileWorld *w = world;
+    const bool statesChanged = rules->states != w->rules.states;
+    w->rules = *rules;
+    w->totalistic = rules_totalistic(&w->rules);
+    rules_counts(&w->rules, &w->birth, &w->survival);
+
+    if (statesChanged) {
+        for (uint64_t i = 0; i < w->len; ++i) {
+            ar_free(w->arena, w->tiles[i]->planes, planesSize(w));
+            w->tiles[i]->planes = NULL;
+        }
+        w->planeCount = w->rules.states > 2 ? 32 - __builtin_clz(w->rules.states - 1u) : 0;
+        w->hash[0] = w->hash[1] = 0;
+        for (uint64_t i = 0; i < w->len; ++i) {
+            Tile *t = w->tiles[i];
+            allocPlanes(w, t);
+            for (int b = 0; b < 2; ++b) {
+                t->hash[b] = hashLiveCells(t, b);
+                w->hash[b] ^= t->hash[b];
+                summarise(w, t, b);
+            }
+        }
+    }
+
+    // quiet tiles were only quiet under the old rules
+    for (uint64_t i = 0; i < w->len; ++i) {
+        w->tiles[i]->quiet = false;
+        w->tiles[i]->stale = true;
+    }
+}
+
+
+static void *create(const EngineConfig *config) {
+    TileWorld *w = heap_calloc(1, sizeof *w);
+    if (!w) return NULL;
+
+    setRules(w, &config->rules);
+    w->kernel = tileKernel_select(NULL);
+
+    w->pool = tp_new(config->threads);
+    w->arena = ar_new();
+    if (!w->pool || !w->arena) {
+        tp_destroy(w->pool);
+        ar_destroy(w->arena);
+        free(w);
+        return NULL;
+    }
+
+    rebuildMap(w);
+    return w;
+}
+
+
+// every tile goes at once, along with the memory held for them
+static void clear(void *world) {
+    TileWorld *w = world;
+    ar_reset(w->arena);
+    ar_trim(w->arena);
+    w->len = 0;
+    w->hash[0] = w->hash[1] = 0;
+    rebuildMap(w);
+}
+
+
+static void destroy(void *world) {
+    TileWorld *w = world;
+    tp_destroy(w->pool);
+    ar_destroy(w->arena);
+    free(w->tiles);
+    free(w->active);
+    free(w->mapKeys);
+    free(w->mapTiles);
+    free(w);
+}
+
+
+static void step(void *world) {
+    TileWorld *w = world;
+    extendHalo(w);
+    scheduleActive(w);
+
+    tp_run(w->pool, (w->activeLen + TILES_PER_TASK - 1) / TILES_PER_TASK, stepTask, w);
+    for (uint64_t i = 0; i < w->activeLen; ++i)
+        w->hash[!w->phase] ^= w->active[i]->hashChange;
+    w->phase = !w->phase;
+
+    // tiles that stayed dead for three generations are dropped; the halo brings them back when needed
+    for (uint64_t i = 0; i < w->len; ++i) {
+        Tile *t = w->tiles[i];
+        t->dropped = t->quiet && t->empty[0] && t->empty[1] && !bordered(w, t);
+    }
+
+    uint64_t len = 0;
+    for (uint64_t i = 0; i < w->len; ++i) {
+        if (w->tiles[i]->dropped)
+            freeTile(w, w->tiles[i]);
+        else
+            w->tiles[len++] = w->tiles[i];
+    }
+
+    if (len != w->len) {
+        w->len = len;
+        rebuildMap(w);
+    }
+}
+
+
+// states the rules do not have are treated as 0
+static void setState(void *world, Cell c, uint8_t state) {
+    TileWorld *w = world;
+    const int32_t x = cell_x(c), y = cell_y(c);
+    const int i = y & (TILE_SIZE - 1);
+    const uint64_t bit = (uint64_t) 1 << (x & (TILE_SIZE - 1));
+    if (state >= w->rules.states)
+        state = 0;
+    Tile *t = state ? claimTile(w, x >> TILE_BITS, y >> TILE_BITS) : findTile(w, x >> TILE_BITS, y >> TILE_BITS);
+    if (!t)
+        return;
+
+    uint64_t *ages = agesOf(w, t, w->phase);
+    const unsigned old = stateOf(w, t->rows[w->phase], ages, i, x & (TILE_SIZE - 1));
+    if (old == state)
+        return;
+
+    t->rows[w->phase][i] = state == 1 ? t->rows[w->phase][i] | bit : t->rows[w->phase][i] & ~bit;
+    for (int p = 0; p < w->planeCount; ++p) {
+        const bool set = state > 1 && ((state - 1u) >> p) & 1;
+        ages[p * TILE_SIZE + i] = set ? ages[p * TILE_SIZE + i] | bit : ages[p * TILE_SIZE + i] & ~bit;
+    }
+
+    const uint64_t change = cell_stateHash(c, old) ^ cell_stateHash(c, state);
+    t->hash[w->phase] ^= change;
+    w->hash[w->phase] ^= change;
+
+    t->quiet = false;
+    t->stale = true;
+    t->changed = true;
+    summarise(w, t, w->phase);
+}
+
+
+static void setCell(void *world, Cell c, bool alive) {
+    setState(world, c, alive);
+}
+
+
+static void load(void *world, const cellset *cells) {
+    for (uint64_t i = 0; i < cells->len; ++i)
+        setCell(world, cells->cells[i], true);
+}
+
+
+// restrict the rows of a tile to the columns inside r; return false if the tile lies outside
+static bool clipTile(const Tile *t, const CellRect *r, uint64_t *columns) {
+    const int64_t x0 = (int64_t) t->tx * TILE_SIZE, y0 = (int64_t) t->ty * TILE_SIZE;
+    if (x0 > r->x1 || x0 + TILE_SIZE - 1 < r->x0 || y0 > r->y1 || y0 + TILE_SIZE - 1 < r->y0)
+        return false;
+
+    *columns = ~(uint64_t) 0;
+    if (r->x0 > x0)
+        *columns &= ~(uint64_t) 0 << (r->x0 - x0);
+    if (r->x1 < x0 + TILE_SIZE - 1)
+        *columns &= ~(uint64_t) 0 >> (TILE_SIZE - 1 - (r->x1 - x0));
+    return true;
+}
+
+
+static void forEachInRect(void *world, const CellRect *r, void (*f)(Cell, void *), void *arg) {
+    TileWorld *w = world;
+    for (uint64_t i = 0; i < w->len; ++i) {
+        const Tile *t = w->tiles[i];
+        uint64_t columns;
+        if (!clipTile(t, r, &columns))
+            continue;
+
+        const int64_t x0 = (int64_t) t->tx * TILE_SIZE, y0 = (int64_t) t->ty * TILE_SIZE;
+        for (int row = 0; row < TILE_SIZE; ++row) {
+            const int64_t y = y0 + row;
+            if (y < r->y0 || y > r->y1)
+                continue;
+            for (uint64_t bits = t->rows[w->phase][row] & columns; bits; bits &= bits - 1)
+                f(cell_make((int32_t) (x0 + __builtin_ctzll(bits)), (int32_t) y), arg);
+        }
+    }
+}
+
+
+static void forEachStateInRect(void *world, const CellRect *r, void (*f)(Cell, uint8_t, void *), void *arg) {
+    TileWorld *w = world;
+    for (uint64_t i = 0; i < w->len; ++i) {
+        const Tile *t = w->tiles[i];
+        uint64_t columns;
+        if (!clipTile(t, r, &columns))
+            continue;
+
+        const uint64_t *ages = agesOf(w, t, w->phase);
+        const int64_t x0 = (int64_t) t->tx * TILE_SIZE, y0 = (int64_t) t->ty * TILE_SIZE;
+        for (int row = 0; row < TILE_SIZE; ++row) {
+            const int64_t y = y0 + row;
+            if (y < r->y0 || y > r->y1)
+                continue;
+
+            uint64_t occupied = t->rows[w->phase][row];
+            for (int p = 0; p < w->planeCount; ++p)
+                occupied |= ages[p * TILE_SIZE + row];
+            for (uint64_t bits = occupied & columns; bits; bits &= bits - 1) {
+                const int x = __builtin_ctzll(bits);
+                f(cell_make((int32_t) (x0 + x), (int32_t) y), (uint8_t) stateOf(w, t->rows[w->phase], ages, row, x), arg);
+            }
+        }
+    }
+}
+
+
+static uint64_t population(void *world) {
+    TileWorld *w = world;
+    uint64_t pop = 0;
+    for (uint64_t i = 0; i < w->len; ++i) {
+        for (int row = 0; row < TILE_SIZE; ++row)
+            pop += __builtin_popcountll(w->tiles[i]->rows[w->phase][row]);
+    }
+    return pop;
+}
+
+
+static uint64_t hash(void *world) {
+    TileWorld *w = world;
+    return w->hash[w->phase];
+}
+
+
+static void arenaStats(void *world, ArenaStats *stats) {
+    TileWorld *w = world;
+    ar_stats(w->arena, stats);
+}
+
+
+const struct GOL_Engine tileEngine = {
+        "tile",
+        create,
+        destroy,
+        step,
+        load,
+        setCell,
+        forEachInRect,
+        population,
+        clear,
+        NULL,
+        hash,
+        setRules,
+        setState,
+        forEachStateInRect,
+        arenaStats
+};
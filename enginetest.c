@@ -0,0 +1,594 @@
+//
+// Created by easy on 16.10.26.
+//
+
+/*
+ * goltest: regression tests of the engines. Engines are checked against a reference that computes
+ * every cell of a window one by one straight from the rules, or against the sorted engine, which
+ * keeps no state beyond its live cells. Exits with status 1 if any check fails.
+ */
+
+#include "engine.h"
+#include "gol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Run {
+    const struct GOL_Engine *engine;
+    void *world;
+} Run;
+
+// the reference: cells x0 <= x < x0 + width, y0 <= y < y0 + height, everything outside is dead
+typedef struct Naive {
+    Rules rules;
+    TopologyType topology;  // a torus or Klein bottle wraps around the window, anything else is a plane
+    int32_t x0, y0, width, height;
+    uint8_t *cells, *next;  // states, row by row
+} Naive;
+
+static int failures;
+
+
+static Run startThreaded(const char *engine, const char *rules, unsigned threads) {
+    EngineConfig config = {.threads = threads};
+    if (rules_parse(&config.rules, rules)) {
+        fprintf(stderr, "Malformed rules \"%s\".\n", rules);
+        exit(1);
+    }
+    const struct GOL_Engine *e = engine_find(engine);
+    void *world = e ? e->create(&config) : NULL;
+    if (!world) {
+        fprintf(stderr, "Could not create engine \"%s\".\n", engine);
+        exit(1);
+    }
+    return (Run) {e, world};
+}
+
+
+static Run start(const char *engine, const char *rules) {
+    return startThreaded(engine, rules, 0);
+}
+
+
+static void placeBlock(Run *r, int32_t x, int32_t y) {
+    for (int32_t dx = 0; dx < 2; ++dx) {
+        for (int32_t dy = 0; dy < 2; ++dy)
+            r->engine->setCell(r->world, cell_make(x + dx, y + dy), true);
+    }
+}
+
+
+static void step(Run *r, int gens) {
+    for (int i = 0; i < gens; ++i)
+        r->engine->step(r->world);
+}
+
+
+static Naive naiveStart(const char *rules, int32_t x0, int32_t y0, int32_t width, int32_t height) {
+    Naive n = {.x0 = x0, .y0 = y0, .width = width, .height = height};
+    n.cells = calloc((size_t) width * height, 1);
+    n.next = calloc((size_t) width * height, 1);
+    if (rules_parse(&n.rules, rules) || !n.cells || !n.next) {
+        fprintf(stderr, "Could not set up the reference for rules \"%s\".\n", rules);
+        exit(1);
+    }
+    return n;
+}
+
+
+static void naiveDestroy(Naive *n) {
+    free(n->cells);
+    free(n->next);
+}
+
+
+// state of a cell given in window coordinates
+static uint8_t naiveGet(const Naive *n, int32_t x, int32_t y) {
+    if (n->topology == TOPOLOGY_TORUS || n->topology == TOPOLOGY_KLEIN) {
+        // crossing the top or bottom edge of a Klein bottle mirrors x
+        if (y < 0 || y >= n->height) {
+            if (n->topology == TOPOLOGY_KLEIN)
+                x = n->width - 1 - x;
+            y = (y + n->height) % n->height;
+        }
+        x = (x + n->width) % n->width;
+    }
+    if (x < 0 || x >= n->width || y < 0 || y >= n->height)
+        return 0;
+    return n->cells[(size_t) y * n->width + x];
+}
+
+
+static void naiveStep(Naive *n) {
+    // only the cells next to the bounding box of the cells not dead can change, unless the window wraps
+    const bool wraps = n->topology == TOPOLOGY_TORUS || n->topology == TOPOLOGY_KLEIN;
+    int32_t x0 = wraps ? 0 : n->width, y0 = wraps ? 0 : n->height;
+    int32_t x1 = wraps ? n->width - 1 : -1, y1 = wraps ? n->height - 1 : -1;
+    for (int32_t y = 0; y < n->height; ++y) {
+        for (int32_t x = 0; x < n->width; ++x) {
+            if (n->cells[(size_t) y * n->width + x]) {
+                x0 = x < x0 ? x : x0;
+                x1 = x > x1 ? x : x1;
+                y0 = y < y0 ? y : y0;
+                y1 = y > y1 ? y : y1;
+            }
+        }
+    }
+    memset(n->next, 0, (size_t) n->width * n->height);
+
+    for (int32_t y = y0 - 1 > 0 ? y0 - 1 : 0; y <= y1 + 1 && y < n->height; ++y) {
+        for (int32_t x = x0 - 1 > 0 ? x0 - 1 : 0; x <= x1 + 1 && x < n->width; ++x) {
+            uint16_t neighbourhood = 0;
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    if (naiveGet(n, x + dx, y + dy) == 1)
+                        neighbourhood |= RULES_BIT(dx, dy);
+                }
+            }
+            // a live cell that does not survive starts dying, dying cells age until they are dead
+            const uint8_t state = naiveGet(n, x, y);
+            uint8_t next;
+            if (state > 1)
+                next = state + 1 < n->rules.states ? state + 1 : 0;
+            else if (rules_next(&n->rules, neighbourhood))
+                next = 1;
+            else
+                next = state && n->rules.states > 2 ? 2 : 0;
+            n->next[(size_t) y * n->width + x] = next;
+        }
+    }
+    uint8_t *swap = n->cells;
+    n->cells = n->next;
+    n->next = swap;
+}
+
+
+// fill a size x size square centred on the origin with live cells, the same ones for every seed
+static cellset *soup(int32_t size, unsigned density, uint64_t seed) {
+    cellset *cells = cs_new();
+    if (!cells) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    for (int32_t y = 0; y < size; ++y) {
+        for (int32_t x = 0; x < size; ++x) {
+            // splitmix64
+            uint64_t z = (seed += 0x9E3779B97F4A7C15u);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+            if ((z ^ (z >> 31)) % 100 < density && cs_push(cells, cell_make(x - size / 2, y - size / 2))) {
+                fprintf(stderr, "Out of memory.\n");
+                exit(1);
+            }
+        }
+    }
+    return cells;
+}
+
+
+static void naiveLoad(Naive *n, const cellset *cells, uint8_t state) {
+    for (uint64_t i = 0; i < cells->len; ++i) {
+        const int32_t x = cell_x(cells->cells[i]) - n->x0, y = cell_y(cells->cells[i]) - n->y0;
+        if (0 <= x && x < n->width && 0 <= y && y < n->height)
+            n->cells[(size_t) y * n->width + x] = state;
+    }
+}
+
+
+typedef struct Comparison {
+    const Naive *reference;
+    uint64_t visits;
+    uint64_t mismatches;
+} Comparison;
+
+
+static void compareCell(Cell c, uint8_t state, void *comparison) {
+    Comparison *cmp = comparison;
+    ++cmp->visits;
+    if (naiveGet(cmp->reference, cell_x(c) - cmp->reference->x0, cell_y(c) - cmp->reference->y0) != state)
+        ++cmp->mismatches;
+}
+
+
+static void compareLive(Cell c, void *comparison) {
+    compareCell(c, 1, comparison);
+}
+
+
+// every cell the engine visits must be in the same state in the reference, and there must be no others
+static void expectMatches(const char *test, int gen, Run *r, const Naive *reference) {
+    Comparison cmp = {reference, 0, 0};
+    const CellRect all = {INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX};
+    if (r->engine->forEachStateInRect)
+        r->engine->forEachStateInRect(r->world, &all, compareCell, &cmp);
+    else
+        r->engine->forEachInRect(r->world, &all, compareLive, &cmp);
+
+    uint64_t expected = 0;
+    for (size_t i = 0; i < (size_t) reference->width * reference->height; ++i)
+        expected += r->engine->forEachStateInRect ? reference->cells[i] != 0 : reference->cells[i] == 1;
+    if (cmp.visits != expected || cmp.mismatches) {
+        printf("FAIL %s: %s engine at generation %d has %llu cells, %llu of them wrong, expected %llu\n",
+               test, r->engine->name, gen, (unsigned long long) cmp.visits, (unsigned long long) cmp.mismatches,
+               (unsigned long long) expected);
+        ++failures;
+    }
+}
+
+
+// compare population and, if the engine keeps track of it, hash of a run with the reference run
+static void expectSame(const char *test, int gen, Run *r, Run *reference) {
+    const uint64_t population = r->engine->population(r->world);
+    const uint64_t expected = reference->engine->population(reference->world);
+    const uint64_t expectedHash = reference->engine->hash(reference->world);
+    const uint64_t hash = r->engine->hash ? r->engine->hash(r->world) : expectedHash;
+    if (population != expected || hash != expectedHash) {
+        printf("FAIL %s: %s engine at generation %d has population %llu and hash %016llx, expected %llu and %016llx\n",
+               test, r->engine->name, gen, (unsigned long long) population, (unsigned long long) hash,
+               (unsigned long long) expected, (unsigned long long) expectedHash);
+        ++failures;
+    }
+}
+
+
+// a cell placed beside a still life dies at once; it must not come back once the still life's tile is quiet
+static void testEditBesideStillLife(const char *engine) {
+    Run r = start(engine, "B3/S23"), reference = start("sorted", "B3/S23");
+    placeBlock(&r, 10, 10);
+    placeBlock(&reference, 10, 10);
+    step(&r, 3);
+    step(&reference, 3);
+    r.engine->setCell(r.world, cell_make(30, 30), true);
+    reference.engine->setCell(reference.world, cell_make(30, 30), true);
+
+    for (int gen = 4; gen < 12; ++gen) {
+        step(&r, 1);
+        step(&reference, 1);
+        expectSame("edit beside a still life", gen, &r, &reference);
+    }
+    r.engine->destroy(r.world);
+    reference.engine->destroy(reference.world);
+}
+
+
+// a glider crossing quiet tiles must wake them up, still lifes and all
+static void testGliderIntoStillLife(const char *engine) {
+    Run r = start(engine, "B3/S23"), reference = start("sorted", "B3/S23");
+    const int32_t glider[][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};     // heading south-east
+    for (size_t i = 0; i < sizeof glider / sizeof *glider; ++i) {
+        r.engine->setCell(r.world, cell_make(glider[i][0], glider[i][1]), true);
+        reference.engine->setCell(reference.world, cell_make(glider[i][0], glider[i][1]), true);
+    }
+    placeBlock(&r, 200, 201);
+    placeBlock(&reference, 200, 201);
+
+    for (int gen = 50; gen <= 1000; gen += 50) {
+        step(&r, 50);
+        step(&reference, 50);
+        expectSame("glider into a still life", gen, &r, &reference);
+    }
+    r.engine->destroy(r.world);
+    reference.engine->destroy(reference.world);
+}
+
+
+static void countVisit(Cell c, void *visits) {
+    (void) c;
+    ++*(uint64_t *) visits;
+}
+
+
+// cells placed twice or loaded over live cells must be counted and visited once, before any step
+static void testPlacedTwice(const char *engine) {
+    Run r = start(engine, "B3/S23");
+    r.engine->setCell(r.world, cell_make(1, 1), true);
+    r.engine->setCell(r.world, cell_make(1, 1), true);
+    cellset *cells = cs_new();
+    if (!cells || cs_push(cells, cell_make(1, 1)) || cs_push(cells, cell_make(2, 1))) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    r.engine->load(r.world, cells);
+    cs_destroy(cells);
+
+    uint64_t visits = 0;
+    const CellRect all = {INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX};
+    r.engine->forEachInRect(r.world, &all, countVisit, &visits);
+    const uint64_t population = r.engine->population(r.world);
+    if (population != 2 || visits != 2) {
+        printf("FAIL cells placed twice: %s engine has population %llu and visits %llu cells, expected 2 and 2\n",
+               r.engine->name, (unsigned long long) population, (unsigned long long) visits);
+        ++failures;
+    }
+    r.engine->destroy(r.world);
+}
+
+
+static void hashLive(Cell c, void *hash) {
+    *(uint64_t *) hash ^= cell_hash(c);
+}
+
+
+// world hash computed from the cells visited, for engines that do not keep one
+static uint64_t visitedHash(Run *r) {
+    uint64_t hash = 0;
+    const CellRect all = {INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX};
+    r->engine->forEachInRect(r->world, &all, hashLive, &hash);
+    return hash;
+}
+
+
+// a random soup stepped one generation at a time must evolve as in the reference
+static void testSoup(const char *engine, const char *rules, unsigned threads, int32_t size) {
+    const int gens = 100;
+    Run r = startThreaded(engine, rules, threads);
+    const int32_t margin = gens + 2;
+    Naive reference = naiveStart(rules, -size / 2 - margin, -size / 2 - margin, size + 2 * margin, size + 2 * margin);
+    char test[64];
+    snprintf(test, sizeof test, "%ssoup under %s", threads > 1 ? "threaded " : "", rules);
+    cellset *cells = soup(size, 40, 1);
+    r.engine->load(r.world, cells);
+    naiveLoad(&reference, cells, 1);
+    cs_destroy(cells);
+
+    for (int gen = 1; gen <= gens; ++gen) {
+        step(&r, 1);
+        naiveStep(&reference);
+        if (gen % 10 == 0)
+            expectMatches(test, gen, &r, &reference);
+    }
+    r.engine->destroy(r.world);
+    naiveDestroy(&reference);
+}
+
+
+// dying states of Generations rules must age, block births and not count as neighbours as in the reference
+static void testGenerations(const char *engine, const char *rules, unsigned threads) {
+    const int gens = 100;
+    const int32_t size = 64, margin = gens + 2;
+    Run r = startThreaded(engine, rules, threads);
+    if (!r.engine->setState) {
+        r.engine->destroy(r.world);
+        return;
+    }
+    Naive reference = naiveStart(rules, -size / 2 - margin, -size / 2 - margin, size + 2 * margin, size + 2 * margin);
+    char test[64];
+    snprintf(test, sizeof test, "Generations soup under %s", rules);
+
+    // live cells and, in between, cells that are already dying
+    cellset *live = soup(size, 35, 3), *dying = soup(size, 15, 4);
+    for (uint64_t i = 0; i < dying->len; ++i)
+        r.engine->setState(r.world, dying->cells[i], 2);
+    naiveLoad(&reference, dying, 2);
+    for (uint64_t i = 0; i < live->len; ++i)
+        r.engine->setState(r.world, live->cells[i], 1);
+    naiveLoad(&reference, live, 1);
+    cs_destroy(live);
+    cs_destroy(dying);
+
+    expectMatches(test, 0, &r, &reference);
+    for (int gen = 1; gen <= gens; ++gen) {
+        step(&r, 1);
+        naiveStep(&reference);
+        if (gen % 10 == 0)
+            expectMatches(test, gen, &r, &reference);
+    }
+    r.engine->destroy(r.world);
+    naiveDestroy(&reference);
+}
+
+
+// bounded universes: edges that are dead, joined or joined with a twist, on one and on several threads
+static void testTopology(const char *topology, unsigned threads) {
+    const int gens = 100;
+    EngineConfig config = {.threads = threads};
+    if (rules_parse(&config.rules, "B3/S23") || engine_parseTopology(&config.topology, topology)) {
+        fprintf(stderr, "Malformed topology \"%s\".\n", topology);
+        exit(1);
+    }
+    Run r = {&denseEngine, denseEngine.create(&config)};
+    if (!r.world) {
+        fprintf(stderr, "Could not create the dense engine for \"%s\".\n", topology);
+        exit(1);
+    }
+    const int32_t width = config.topology.width, height = config.topology.height;
+    Naive reference = naiveStart("B3/S23", 0, 0, width, height);
+    reference.topology = config.topology.type;
+    char test[64];
+    snprintf(test, sizeof test, "%s%s", threads > 1 ? "threaded " : "", topology);
+
+    // a soup covering the whole universe, so that patterns cross every edge and corner
+    const int32_t size = width > height ? width : height;
+    cellset *cells = soup(size, 40, 5);
+    for (uint64_t i = 0; i < cells->len; ++i) {
+        const int32_t x = cell_x(cells->cells[i]) + size / 2, y = cell_y(cells->cells[i]) + size / 2;
+        if (x < width && y < height) {
+            r.engine->setCell(r.world, cell_make(x, y), true);
+            reference.cells[(size_t) y * width + x] = 1;
+        }
+    }
+    cs_destroy(cells);
+
+    for (int gen = 1; gen <= gens; ++gen) {
+        step(&r, 1);
+        naiveStep(&reference);
+        if (gen % 10 == 0)
+            expectMatches(test, gen, &r, &reference);
+    }
+    r.engine->destroy(r.world);
+    naiveDestroy(&reference);
+}
+
+
+// jumps of any length must land on the generation stepped to one at a time
+static void testJumps(const char *engine) {
+    Run r = start(engine, "B3/S23"), reference = start("sorted", "B3/S23");
+    if (!r.engine->jump) {
+        r.engine->destroy(r.world);
+        reference.engine->destroy(reference.world);
+        return;
+    }
+    cellset *cells = soup(32, 40, 2);
+    r.engine->load(r.world, cells);
+    reference.engine->load(reference.world, cells);
+    cs_destroy(cells);
+
+    const uint64_t targets[] = {1, 2, 7, 64, 100, 513, 1000, 3000};
+    uint64_t gen = 0;
+    for (size_t i = 0; i < sizeof targets / sizeof *targets; ++i) {
+        while (gen < targets[i])
+            gen += r.engine->jump(r.world, targets[i] - gen);
+        step(&reference, (int) (targets[i] - (i ? targets[i - 1] : 0)));
+
+        const uint64_t population = r.engine->population(r.world), hash = visitedHash(&r);
+        const uint64_t expected = reference.engine->population(reference.world);
+        const uint64_t expectedHash = reference.engine->hash(reference.world);
+        if (gen != targets[i] || population != expected || hash != expectedHash) {
+            printf("FAIL jumps: %s engine at generation %llu has population %llu and hash %016llx, "
+                   "expected generation %llu with %llu and %016llx\n",
+                   r.engine->name, (unsigned long long) gen, (unsigned long long) population,
+                   (unsigned long long) hash, (unsigned long long) targets[i], (unsigned long long) expected,
+                   (unsigned long long) expectedHash);
+            ++failures;
+        }
+    }
+    r.engine->destroy(r.world);
+    reference.engine->destroy(reference.world);
+}
+
+
+// the letters of every count must split its configurations into disjoint isotropic classes
+static void testHensel(void) {
+    // representatives of the letters up to two neighbours: N is -y, E is +x
+    const struct {const char *rules; int dx[2], dy[2];} known[] = {
+            {"B1c/S", {1, 1}, {-1, -1}},
+            {"B1e/S", {0, 0}, {-1, -1}},
+            {"B2c/S", {1, 1}, {-1, 1}},
+            {"B2e/S", {0, 1}, {-1, 0}},
+            {"B2k/S", {0, 1}, {-1, 1}},
+            {"B2a/S", {0, 1}, {-1, -1}},
+            {"B2i/S", {0, 0}, {-1, 1}},
+            {"B2n/S", {1, -1}, {-1, 1}}
+    };
+    for (size_t i = 0; i < sizeof known / sizeof *known; ++i) {
+        Rules rules;
+        const uint16_t neighbourhood = RULES_BIT(known[i].dx[0], known[i].dy[0]) | RULES_BIT(known[i].dx[1], known[i].dy[1]);
+        if (rules_parse(&rules, known[i].rules) || !rules_next(&rules, neighbourhood)) {
+            printf("FAIL Hensel letters: %s does not give birth to its own configuration\n", known[i].rules);
+            ++failures;
+        }
+    }
+
+    const char *letters = "ceaiknjqrytwz";
+    for (int count = 1; count <= 7; ++count) {
+        Rules all, letter, negated;
+        char rulestring[16];
+        snprintf(rulestring, sizeof rulestring, "B%d/S", count);
+        rules_parse(&all, rulestring);
+        uint8_t claimed[RULES_SIZE] = {0};
+        for (const char *l = letters; *l; ++l) {
+            snprintf(rulestring, sizeof rulestring, "B%d%c/S", count, *l);
+            if (rules_parse(&letter, rulestring))
+                continue;   // no such letter for this count
+            snprintf(rulestring, sizeof rulestring, "B%d-%c/S", count, *l);
+            rules_parse(&negated, rulestring);
+            for (unsigned n = 0; n < RULES_SIZE; ++n) {
+                claimed[n] += letter.next[n];
+                if (letter.next[n] == negated.next[n] && all.next[n]) {
+                    printf("FAIL Hensel letters: B%d%c and B%d-%c agree on configuration %03x\n", count, *l, count, *l, n);
+                    ++failures;
+                }
+            }
+        }
+        for (unsigned n = 0; n < RULES_SIZE; ++n) {
+            if (claimed[n] != all.next[n]) {
+                printf("FAIL Hensel letters: configuration %03x of %d neighbours has %d letters\n", n, count, claimed[n]);
+                ++failures;
+            }
+        }
+    }
+}
+
+
+// no engine can honour births in empty space
+static void testB0Rejected(void) {
+    const char *b0[] = {"B0/S", "B03/S23", "B0/S8", "S23/03"};
+    for (size_t i = 0; i < sizeof b0 / sizeof *b0; ++i) {
+        Rules rules;
+        if (!rules_parse(&rules, b0[i])) {
+            printf("FAIL B0 rules: %s is accepted\n", b0[i]);
+            ++failures;
+        }
+    }
+}
+
+
+// a world periodic from generation 0 on, and one that only settles after a generation
+static void testPeriodStart(const char *engine) {
+    const struct {const char *rle; uint64_t period, since;} cases[] = {
+            {"x = 3, y = 1\n3o!\n", 2, 0},     // blinker
+            {"x = 2, y = 2\n2o$bo!\n", 1, 1}   // becomes a block
+    };
+    for (size_t i = 0; i < sizeof cases / sizeof *cases; ++i) {
+        const GOL_Settings settings = {.engine = engine, .detectPeriods = true};
+        GOL_Universe *u = gol_create(&settings);
+        GOL_Cells *cells = gol_readRLE(cases[i].rle);
+        if (!u || !cells) {
+            fprintf(stderr, "Could not create a universe with engine \"%s\".\n", engine);
+            exit(1);
+        }
+        gol_load(u, cells);
+        gol_freeCells(cells);
+        gol_step(u, 20);
+
+        uint64_t period = 0, since = 0;
+        gol_period(u, &period, &since);
+        if (period != cases[i].period || since != cases[i].since) {
+            printf("FAIL period from the start: %s engine finds period %llu since generation %llu, expected %llu since %llu\n",
+                   engine, (unsigned long long) period, (unsigned long long) since,
+                   (unsigned long long) cases[i].period, (unsigned long long) cases[i].since);
+            ++failures;
+        }
+        gol_destroy(u);
+    }
+}
+
+
+int main(void) {
+    testHensel();
+    testB0Rejected();
+    const char *engines[] = {"sorted", "hash", "tile", "hashlife", "sweep", "sortcount"};
+    for (size_t i = 0; i < sizeof engines / sizeof *engines; ++i) {
+        testEditBesideStillLife(engines[i]);
+        testGliderIntoStillLife(engines[i]);
+        testPlacedTwice(engines[i]);
+        testSoup(engines[i], "B3/S23", 1, 32);
+        // isotropic non-totalistic rules, which the counting kernels cannot compute
+        testSoup(engines[i], "B2-a/S12", 1, 32);
+        testSoup(engines[i], "B3-k4ce/S23-a", 1, 32);
+        testJumps(engines[i]);
+        testGenerations(engines[i], "B2/S/C3", 1);
+        testGenerations(engines[i], "345/2/4", 1);
+        testGenerations(engines[i], "B2-a3/S12/C7", 1);
+        if (engine_find(engines[i])->hash)
+            testPeriodStart(engines[i]);
+    }
+    // large enough to keep several threads busy with tiles and runs of keys of their own
+    const char *threaded[] = {"tile", "sortcount"};
+    for (size_t i = 0; i < sizeof threaded / sizeof *threaded; ++i)
+        testSoup(threaded[i], "B3/S23", 4, 384);
+
+    // sizes off multiples of the 64 cells of a word, to exercise the masks of the last column and rows
+    const char *topologies[] = {"P:100x70", "T:100x70", "K:100x70", "T:64x64", "K:130x200", "T:1x90"};
+    for (size_t i = 0; i < sizeof topologies / sizeof *topologies; ++i) {
+        testTopology(topologies[i], 1);
+        testTopology(topologies[i], 3);
+    }
+
+    if (failures)
+        printf("%d checks failed.\n", failures);
+    else
+        puts("All checks passed.");
+    return failures != 0;
+}
@@ -0,0 +1,24 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "font.h"
+
+// glyphs of the characters ' ' to '_'; each octal digit is a row from top to bottom
+static const uint16_t glyphs[] = {
+        000000, 022202, 055000, 057575, 036236, 051245, 025253, 022000,    //   ! " # $ % & '
+        012221, 042224, 005250, 002720, 000024, 000700, 000002, 011244,    // ( ) * + , - . /
+        075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111,    // 0 1 2 3 4 5 6 7
+        075757, 075717, 002020, 002024, 012421, 007070, 042124, 061202,    // 8 9 : ; < = > ?
+        025743, 025755, 065656, 034443, 065556, 074647, 074644, 034553,    // @ A B C D E F G
+        055755, 072227, 011152, 055655, 044447, 057755, 065555, 025552,    // H I J K L M N O
+        065644, 025563, 065655, 034216, 072222, 055557, 055552, 055775,    // P Q R S T U V W
+        055255, 055222, 071247, 032223, 044211, 062226, 025000, 000007,    // X Y Z [ \ ] ^ _
+};
+
+
+uint16_t font_glyph(char c) {
+    if (c >= 'a' && c <= 'z')
+        c = (char) (c - 'a' + 'A');
+    return c >= ' ' && c <= '_' ? glyphs[c - ' '] : 0;
+}
@@ -0,0 +1,21 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_FONT_H
+#define GAMEOFLIFE_FONT_H
+
+#include <stdint.h>
+
+#define FONT_WIDTH 3
+#define FONT_HEIGHT 5
+
+/**
+ * Pixels of a character of the embedded bitmap font.
+ * Row y of the glyph is (glyph >> 3 * (FONT_HEIGHT - 1 - y)) & 7, whose most significant bit is the left pixel.
+ * @param c character; lower case letters are drawn in upper case
+ * @return glyph of the character; blank for characters the font does not have
+ */
+uint16_t font_glyph(char c);
+
+#endif //GAMEOFLIFE_FONT_H
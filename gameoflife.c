@@ -6,29 +6,26 @@
 #include "sdl_viewport.h"
 #include "square0_png.h"
 #include "square1_png.h"
+#include "world.h"
+#include "simulation.h"
+#include "profile.h"
+#include "trace.h"
+#include "font.h"
+#include "arena.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
-#include <errno.h>
 #include <math.h>
-#include <axvector.h>
 #include <axqueue.h>
-#include <axstack.h>
 #include <SDL.h>
 #include <SDL_image.h>
 
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-
 typedef enum InputType {
     ZOOM, CAMERA_VERTICAL, CAMERA_HORIZONTAL, SQUARE_PLACE,
     SQUARE_DELETE, PAUSE, GENOCIDE, TICKRATE, WINDOW_RESIZE,
-    BACKUP, RESTORE, TEXTURE
+    BACKUP, RESTORE, TEXTURE, RULE, HYPERSPEED, HUD, TRACE
 } InputType;
 
-typedef struct Square {
-    double x, y;
-} Square;
-
 typedef struct Input {
     union {
         double magnitude;
@@ -44,64 +41,46 @@ typedef struct MouseTracker {
     int xDown, yDown;
 } MouseTracker;
 
-struct SingleRule {
-    Uint8 nums[8];
-    Uint8 len;
-    bool isRange;
-};
-
-typedef struct Rules {
-    struct SingleRule birth, survival;
-} Rules;
-
-// set origin to NULL before calling filter with removeDuplicates()
-struct args_removeDuplicates {
-    int (*comp)(const void *, const void *);
-    void *origin;
-};
-
 
 static bool tick(void);
 static bool handleEvents(void);
-static void *getTinyMemory(void);
-static void update(void);
+static Input *newInput(void);
 static void draw(void);
-static void destructSquare(void *);
-static void destructInput(void *);
-static void destructSnapshot(void *);
-static bool filterEqualSquares(const void *, void *);
-static bool removeDuplicates(const void *, void *);
-static void *mapNewSquares(void *);
-static int compareSquares(const void *, const void *);
 static void processInputs(void);
-static void processLife(void);
-static void loadPlaintextPattern(const char *);
-static char *loadRLEPattern(const char *);
-static Rules parseRulestring(const char *);
+static bool typeRule(const SDL_Event *);
+static void showStatus(const Frame *);
+static void drawHud(void);
+static void writeProfile(void);
+static void writeTrace(void);
 
 
 static SDL_Window *window;
 static SDL_Renderer *renderer;
 static SDL_Texture *textures[2];
 static SDL_Texture *chosenTexture;
-static Rules rules;
-static axstack *tinyPool;
-static axvector *squares;
+static arena *inputArena;      // inputs of the current frame, released at once once processed
+static Simulation *simulation;
 static axqueue *inputs;
-static axstack *snapshots;
+static char ruleInput[64];      // rulestring being typed, applied by RULE
+static bool typingRule;
 static DRect camera;
 static DRect defaultCamera;     // width is always the same, height is multiplied by display ratio
 static double zoom;
 static MouseTracker mouseleft;
 static MouseTracker mouseright;
-static Uint64 updateAccumulator;
-static Uint64 tickTimeAccumulator;
-static Uint64 updatesPerSec;
 static Uint64 tickrate;
 static bool paused;
+static bool hyperspeed;
+static char statusTitle[96];    // window title last set by showStatus()
+static bool showHud;
+static FILE *profileCSV;
+static Uint64 profileStart;             // ns
+static Uint64 csvCounts[PROF_PHASES];   // samples and ns of every phase up to the latest CSV row
+static Uint64 csvTotals[PROF_PHASES];
+static const char *traceFile;           // NULL if not tracing
 
 
-void gameOfLife(int w, int h, unsigned tickrate_, struct GOL_Pattern patinfo) {
+void gameOfLife(int w, int h, unsigned tickrate_, struct GOL_Pattern patinfo, struct GOL_Options options) {
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER);
 
     window = SDL_CreateWindow("Game of Life", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, w, h, SDL_WINDOW_RESIZABLE);
@@ -113,42 +92,59 @@ void gameOfLife(int w, int h, unsigned tickrate_, struct GOL_Pattern patinfo) {
     chosenTexture = *textures;
     SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, SDL_ALPHA_OPAQUE);
     SDL_DisplayMode dm; SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &dm);
-    squares = axv_setDestructor(axv_setComparator(axv_new(), compareSquares), destructSquare);
-    inputs = axq.setDestructor(axq.new(), destructInput);
-    tinyPool = axs.setDestructor(axs.new(), free);
-    snapshots = axs.setDestructor(axs.new(), destructSnapshot);
-    updatesPerSec = dm.refresh_rate;
+    inputs = axq.new();
+    inputArena = ar_new();
+    if (!inputs || !inputArena) {
+        fprintf(stderr, "Could not allocate memory for the inputs.\n");
+        abort();
+    }
     tickrate = tickrate_;
     zoom = 1. / (1 << 2);
     paused = true;
     defaultCamera = (DRect) {0, 0, 120, ((double) h / (double) w) * 120};   // display ratio in height
     camera = (DRect) {0, 0, defaultCamera.w * zoom, defaultCamera.h * zoom};
 
-    if (patinfo.pattern) {
-        if (patinfo.type == GOL_PLAINTEXT)
-            loadPlaintextPattern(patinfo.pattern);
-        if (patinfo.type == GOL_RLE) {
-            char *rulestring = loadRLEPattern(patinfo.pattern);
-            if (!patinfo.rules) {
-                patinfo.rules = rulestring;
-                patinfo.freeRulestring = true;
-            }
-            else free(rulestring);
+    if (options.profile) {
+        profileCSV = fopen(options.profile, "w");
+        if (profileCSV) {
+            fputs("seconds,phase,samples,total_ns,p50_ns,p99_ns,max_ns\n", profileCSV);
+            ProfileMark start;
+            prof_mark(&start);
+            profileStart = start.ns;
+            prof_enable(true);
+        } else {
+            fprintf(stderr, "Could not open \"%s\" for writing, not profiling.\n", options.profile);
         }
     }
 
-    rules = parseRulestring(patinfo.rules ? patinfo.rules : "B3/S23");
-    if (patinfo.freeRulestring)
-        free((void *) patinfo.rules);
-    if (patinfo.freePattern)
-        free((void *) patinfo.pattern);
+    if (options.counters)
+        prof_enableCounters();
+    trace_nameThread("front end");
+    if (options.trace) {
+        if (trace_enable())
+            fprintf(stderr, "Could not allocate the trace buffers, not tracing.\n");
+        else
+            traceFile = options.trace;
+    }
+
+    // the universe is only touched by the simulation thread from here on
+    GOL_Universe *universe = world_create(patinfo, options, true);
+    simulation = sim_create(universe, tickrate, 1. / (dm.refresh_rate > 0 ? dm.refresh_rate : 60));
+    if (!simulation) {
+        fprintf(stderr, "Could not start the simulation thread.\n");
+        abort();
+    }
 
     while (tick());
 
-    axs.destroy(snapshots);
-    axv_destroy(squares);
+    sim_destroy(simulation);
+    if (traceFile)
+        writeTrace();
+    gol_destroy(universe);
+    if (profileCSV)
+        fclose(profileCSV);
     axq.destroy(inputs);
-    axs.destroy(tinyPool);
+    ar_destroy(inputArena);
     SDL_DestroyTexture(textures[0]);
     SDL_DestroyTexture(textures[1]);
     SDL_DestroyRenderer(renderer);
@@ -158,159 +154,36 @@ void gameOfLife(int w, int h, unsigned tickrate_, struct GOL_Pattern patinfo) {
 
 
 static bool tick(void) {
-    Uint64 starttime = SDL_GetPerformanceCounter();
-
-    if (handleEvents())
+    trace_begin("tick");
+    trace_begin("events");
+    const bool quit = handleEvents();
+    trace_end("events");
+    if (quit) {
+        trace_end("tick");
         return false;
-    update();
-    draw();
-
-    Uint64 difftime = SDL_GetPerformanceCounter() - starttime;
-    updateAccumulator += difftime;
-    tickTimeAccumulator += difftime * !paused;
-    return true;
-}
-
-
-static void update(void) {
-    const Uint64 updateDuration = SDL_GetPerformanceFrequency() / updatesPerSec;
-    const Uint64 gametickDuration = SDL_GetPerformanceFrequency() / tickrate;
-
-    processInputs();
-    if (updateAccumulator >= updateDuration) {
-        if (!paused) {
-            Uint64 frametimeConsumed = 0;
-            while (tickTimeAccumulator >= gametickDuration && frametimeConsumed < updateDuration) {
-                Uint64 starttime = SDL_GetPerformanceCounter();
-                processLife();
-                frametimeConsumed += SDL_GetPerformanceCounter() - starttime;
-                tickTimeAccumulator -= gametickDuration;
-            }
-        }
-        updateAccumulator -= updateDuration;
-    }
-}
-
-
-// insertion sort the last n items into the vector (obvious pre-condition: rest of vector is sorted)
-static void insertionSortTail(axvector *v, int n) {
-    if (n <= 0)
-        return;
-
-    axvsnap s1 = axv_snapshot(v);
-    s1.i = axv_len(v) - n;
-    axvsnap s2 = axv_snapshot(v);
-    int (*cmp)(const void *, const void *) = axv_getComparator(v);
-
-    for (; s1.i < s1.len; ++s1.i) {
-        for (s2.i = s1.i; s2.i > 0; --s2.i) {
-            if (cmp(&s2.vec[s2.i], &s2.vec[s2.i - 1]) >= 0)
-                break;
-            void *tmp = s2.vec[s2.i];
-            s2.vec[s2.i] = s2.vec[s2.i - 1];
-            s2.vec[s2.i - 1] = tmp;
-        }
-    }
-}
-
-
-static bool determineWorthy(void *square, void *args) {
-    axvector *survivors = ((axvector **) args)[0];
-    axvector *potentials = ((axvector **) args)[1];
-    Square *s = square;
-    int taillen = 0;
-    Uint8 neighbours = 0;
-
-    for (double offsetX = -1; offsetX <= +1; ++offsetX) {
-        for (double offsetY = -1; offsetY <= +1; ++offsetY) {
-            if (offsetX == 0 && offsetY == 0)
-                continue;
-
-            Square neighbour = {s->x + offsetX, s->y + offsetY};
-            long i = axv_binarySearch(squares, &neighbour);
-            neighbours += i != -1;
-
-            if (i == -1 && axv_binarySearch(potentials, &neighbour) == -1) {
-                Square *potential = getTinyMemory();
-                *potential = neighbour;
-                axv_push(potentials, potential);
-                ++taillen;
-            }
-        }
-    }
-
-    // insertion sorting the last few items is HUGELY more efficient than
-    // calling axv_sort(potentials) every damn time this function is called (which is a lot!)
-    insertionSortTail(potentials, taillen);
-
-    if (rules.survival.isRange) {
-        if (rules.survival.nums[0] <= neighbours && neighbours <= rules.survival.nums[1])
-            axv_push(survivors, s);
-    } else {
-        if (memchr(rules.survival.nums, neighbours, rules.birth.len))
-            axv_push(survivors, s);
     }
 
+    ProfileMark start, end;
+    trace_begin("inputs");
+    prof_mark(&start);
+    processInputs();
+    prof_mark(&end);
+    prof_record(PROF_INPUTS, &start, &end, 0);
+    trace_end("inputs");
+    draw();
+    if (profileCSV)
+        writeProfile();
+    trace_end("tick");
     return true;
 }
 
 
-static bool determineSpawning(const void *square, void *_) {
-    (void) _;
-    const Square *s = square;
-    Uint8 neighbours = 0;
-
-    for (double offsetX = -1; offsetX <= +1; ++offsetX) {
-        for (double offsetY = -1; offsetY <= +1; ++offsetY) {
-            if (offsetX == 0 && offsetY == 0)
-                continue;
-
-            Square ns = {s->x + offsetX, s->y + offsetY};
-            long i = axv_binarySearch(squares, &ns);
-            neighbours += i != -1;
-
-            if (neighbours > rules.birth.nums[rules.birth.len - 1])
-                return false;
-        }
-    }
-
-    if (rules.birth.isRange)
-        return rules.birth.nums[0] <= neighbours && neighbours <= rules.birth.nums[1];
-    else
-        return memchr(rules.birth.nums, neighbours, rules.birth.len);
-}
-
-
-static bool keepIdenticalSquares(const void *square, void *survivors) {
-    if (square == axv_top(survivors)) {
-        axv_pop(survivors);
-        return true;
-    } else {
-        return false;
-    }
-}
-
-
-static void processLife(void) {
-    axvector *potentials = axv_setDestructor(axv_setComparator(axv_new(), compareSquares), destructSquare);
-    axvector *survivors = axv_new();
-    struct args_removeDuplicates argsrd = {axv_getComparator(squares), NULL};
-    axv_filter(axv_sort(squares), removeDuplicates, &argsrd);
-    axv_foreach(squares, determineWorthy, (axvector *[2]) {survivors, potentials});
-    axv_filter(potentials, determineSpawning, NULL);
-    axv_filter(squares, keepIdenticalSquares, axv_reverse(survivors));
-    axv_extend(squares, potentials);
-    axv_destroy(survivors);
-    axv_destroy(potentials);
-}
-
-
 static void processInputs(void) {
     int renW;   // width only because height is composite of width times display ratio
     SDL_GetRendererOutputSize(renderer, &renW, NULL);
 
-    for (Input *input; axq.len(inputs); axs.push(tinyPool, input)) {
-        input = axq.dequeue(inputs);
+    while (axq.len(inputs)) {
+        Input *input = axq.dequeue(inputs);
 
         switch (input->type) {
         case CAMERA_VERTICAL: {
@@ -345,28 +218,28 @@ static void processInputs(void) {
             break;
         }
         case SQUARE_PLACE: {
-            Square *square = getTinyMemory();
             double ratio = renW / camera.w;
-            square->x = floor(camera.x + (double) input->x / ratio);
-            square->y = floor(camera.y + (double) input->y / ratio);
-            axv_push(squares, square);
+            sim_setCell(simulation,
+                    (Sint32) floor(camera.x + (double) input->x / ratio),
+                    (Sint32) floor(camera.y + (double) input->y / ratio),
+                    1);
             break;
         }
         case SQUARE_DELETE: {
             double cameraRatio = renW / camera.w;
-            Square square = {
-                    floor(camera.x + (double) input->x / cameraRatio),
-                    floor(camera.y + (double) input->y / cameraRatio)
-            };
-            axv_filter(squares, filterEqualSquares, &square);
+            sim_setCell(simulation,
+                    (Sint32) floor(camera.x + (double) input->x / cameraRatio),
+                    (Sint32) floor(camera.y + (double) input->y / cameraRatio),
+                    0);
             break;
         }
         case PAUSE: {
             paused = !paused;
+            sim_setPaused(simulation, paused);
             break;
         }
         case GENOCIDE: {
-            axv_clear(squares);
+            sim_clear(simulation);
             break;
         }
         case TICKRATE: {
@@ -379,6 +252,7 @@ static void processInputs(void) {
             tickrate += speedOffset;
             if ((Sint64) tickrate < 1)
                 tickrate = 1;
+            sim_setTickrate(simulation, tickrate);
             break;
         }
         case WINDOW_RESIZE: {
@@ -391,61 +265,117 @@ static void processInputs(void) {
             break;
         }
         case BACKUP: {
-            axs.push(snapshots, axv_setDestructor(axv_map(axv_copy(squares), mapNewSquares), axv_getDestructor(squares)));
+            sim_backup(simulation);
             break;
         }
         case RESTORE: {
-            if (axs.len(snapshots)) {
-                axv_destroy(squares);
-                squares = axs.pop(snapshots);
-            }
+            sim_restore(simulation);
             break;
         }
         case TEXTURE: {
             chosenTexture = textures[input->x];
             break;
         }
+        case RULE: {
+            sim_setRules(simulation, ruleInput);
+            break;
+        }
+        case HYPERSPEED: {
+            hyperspeed = !hyperspeed;
+            sim_setHyperspeed(simulation, hyperspeed);
+            break;
+        }
+        case HUD: {
+            showHud = !showHud;
+            prof_enable(showHud || profileCSV);
+            break;
+        }
+        case TRACE: {
+            if (traceFile)
+                writeTrace();
+            break;
+        }
         }
     }
+    ar_reset(inputArena);
+}
+
+
+// live cells keep their texture, dying cells fade from orange to dark red with age
+static void drawCell(const FrameCell *c, unsigned states, SDL_Rect *vdst) {
+    SDL_FRect dst;
+    DRect pos = {c->x, c->y, 1, 1};
+    sdl_getViewportDstFRect(&camera, &pos, vdst, &dst);
+    if (c->state == 1) {
+        SDL_RenderCopyF(renderer, chosenTexture, NULL, &dst);
+        return;
+    }
+
+    const double age = (double) (c->state - 1) / (states - 1);
+    SDL_SetRenderDrawColor(renderer, (Uint8) (0xFF - 0x90 * age), (Uint8) (0xA0 - 0xA0 * age), 0x20, SDL_ALPHA_OPAQUE);
+    SDL_RenderFillRectF(renderer, &dst);
 }
 
 
 static void draw(void) {
+    ProfileMark start, end;
+    trace_begin("draw");
+    prof_mark(&start);
     SDL_RenderClear(renderer);
 
     SDL_Rect vdst;
     vdst.x = vdst.y = 0;
     SDL_GetRendererOutputSize(renderer, &vdst.w, &vdst.h);
-    DRect pos;
-    pos.w = pos.h = 1;
-
-    for (axvsnap s = axv_snapshot(squares); s.i < s.len; ++s.i) {
-        SDL_FRect dst;
-        Square *square = s.vec[s.i];
-        pos.x = square->x;
-        pos.y = square->y;
-        if (sdl_inViewport(&camera, &pos)) {
-            sdl_getViewportDstFRect(&camera, &pos, &vdst, &dst);
-            SDL_RenderCopyF(renderer, chosenTexture, NULL, &dst);
+
+    // every cell overlapping the camera, including those only touching its edges
+    const Sint32 x0 = (Sint32) fmax(floor(camera.x) - 1, INT32_MIN);
+    const Sint32 y0 = (Sint32) fmax(floor(camera.y) - 1, INT32_MIN);
+    const Sint32 x1 = (Sint32) fmin(ceil(camera.x + camera.w), INT32_MAX);
+    const Sint32 y1 = (Sint32) fmin(ceil(camera.y + camera.h), INT32_MAX);
+    sim_setView(simulation, x0, y0, x1, y1);
+
+    // the frame may cover more than the camera or lag behind it for a frame while the camera moves
+    const Frame *frame = sim_frame(simulation);
+    Uint64 drawn = 0;
+    for (Uint64 i = 0; i < frame->len; ++i) {
+        const FrameCell *c = &frame->cells[i];
+        if (c->x >= x0 && c->x <= x1 && c->y >= y0 && c->y <= y1) {
+            drawCell(c, frame->states, &vdst);
+            ++drawn;
         }
     }
-
+    if (frame->states > 2)
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, SDL_ALPHA_OPAQUE);   // background
+    showStatus(frame);
+    if (showHud)
+        drawHud();
+
+    prof_mark(&end);
+    prof_record(PROF_DRAW, &start, &end, drawn);
+    trace_end("draw");
+    // waits for the display with vsync, which is where stalled frames show
+    trace_begin("present");
     SDL_RenderPresent(renderer);
+    trace_end("present");
 }
 
 
 static bool handleEvents(void) {
+    // the oldest inputs are dropped; their memory is released with the rest of the frame's
     while (axq.len(inputs) > 1024)
-        axs.push(tinyPool, axq.dequeue(inputs));
+        axq.dequeue(inputs);
 
     for (SDL_Event e; SDL_PollEvent(&e); ) {
+        if (typingRule && typeRule(&e))
+            continue;
+
         if (e.type == SDL_KEYDOWN) {
             switch (e.key.keysym.sym) {
             case SDLK_ESCAPE:
                 return true;
             case SDLK_UP:
             case SDLK_w: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = CAMERA_VERTICAL;
                 input->magnitude = -1;
                 input->usedMouse = false;
@@ -454,7 +384,7 @@ static bool handleEvents(void) {
             }
             case SDLK_DOWN:
             case SDLK_s: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = CAMERA_VERTICAL;
                 input->magnitude = 1;
                 input->usedMouse = false;
@@ -463,7 +393,7 @@ static bool handleEvents(void) {
             }
             case SDLK_LEFT:
             case SDLK_a: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = CAMERA_HORIZONTAL;
                 input->magnitude = -1;
                 input->usedMouse = false;
@@ -472,7 +402,7 @@ static bool handleEvents(void) {
             }
             case SDLK_RIGHT:
             case SDLK_d: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = CAMERA_HORIZONTAL;
                 input->magnitude = 1;
                 input->usedMouse = false;
@@ -481,7 +411,7 @@ static bool handleEvents(void) {
             }
             case SDLK_PLUS:
             case SDLK_KP_PLUS: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = ZOOM;
                 input->magnitude = 1;
                 axq.enqueue(inputs, input);
@@ -489,7 +419,7 @@ static bool handleEvents(void) {
             }
             case SDLK_MINUS:
             case SDLK_KP_MINUS: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = ZOOM;
                 input->magnitude = -1;
                 axq.enqueue(inputs, input);
@@ -498,46 +428,71 @@ static bool handleEvents(void) {
             case SDLK_RETURN:
             case SDLK_KP_ENTER:
             case SDLK_p: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = PAUSE;
                 axq.enqueue(inputs, input);
                 break;
             }
             case SDLK_BACKSPACE: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = GENOCIDE;
                 axq.enqueue(inputs, input);
                 break;
             }
             case SDLK_q: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = TICKRATE;
                 input->magnitude = -1;
                 axq.enqueue(inputs, input);
                 break;
             }
             case SDLK_e: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = TICKRATE;
                 input->magnitude = 1;
                 axq.enqueue(inputs, input);
                 break;
             }
             case SDLK_b: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = BACKUP;
                 axq.enqueue(inputs, input);
                 break;
             }
             case SDLK_r: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = RESTORE;
                 axq.enqueue(inputs, input);
                 break;
             }
+            case SDLK_F3: {
+                Input *input = newInput();
+                input->type = HUD;
+                axq.enqueue(inputs, input);
+                break;
+            }
+            case SDLK_F4: {
+                Input *input = newInput();
+                input->type = TRACE;
+                axq.enqueue(inputs, input);
+                break;
+            }
+            case SDLK_h: {
+                Input *input = newInput();
+                input->type = HYPERSPEED;
+                axq.enqueue(inputs, input);
+                break;
+            }
+            case SDLK_TAB: {
+                // TAB produces no text input, so the prompt starts out empty
+                typingRule = true;
+                *ruleInput = '\0';
+                SDL_SetWindowTitle(window, "Game of Life - new rule: ");
+                break;
+            }
             case SDLK_KP_1:
             case SDLK_1: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = TEXTURE;
                 input->x = 0;
                 axq.enqueue(inputs, input);
@@ -545,7 +500,7 @@ static bool handleEvents(void) {
             }
             case SDLK_KP_2:
             case SDLK_2: {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = TEXTURE;
                 input->x = 1;
                 axq.enqueue(inputs, input);
@@ -561,12 +516,12 @@ static bool handleEvents(void) {
 
         else if (e.type == SDL_MOUSEMOTION) {
             if (e.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK)) {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = CAMERA_VERTICAL;
                 input->magnitude = -e.motion.yrel;
                 input->usedMouse = true;
                 axq.enqueue(inputs, input);
-                input = getTinyMemory();
+                input = newInput();
                 input->type = CAMERA_HORIZONTAL;
                 input->magnitude = -e.motion.xrel;
                 input->usedMouse = true;
@@ -581,7 +536,7 @@ static bool handleEvents(void) {
             SDL_GetMouseState(&xUp, &yUp);
 
             if (tracker->xDown == xUp && tracker->yDown == yUp) {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = left ? SQUARE_PLACE : SQUARE_DELETE;
                 input->x = xUp;
                 input->y = yUp;
@@ -590,7 +545,7 @@ static bool handleEvents(void) {
         }
 
         else if (e.type == SDL_MOUSEWHEEL) {
-            Input *input = getTinyMemory();
+            Input *input = newInput();
             input->type = ZOOM;
             input->magnitude = e.wheel.preciseY;
             axq.enqueue(inputs, input);
@@ -598,7 +553,7 @@ static bool handleEvents(void) {
 
         else if (e.type == SDL_WINDOWEVENT) {
             if (e.window.event == SDL_WINDOWEVENT_RESIZED) {
-                Input *input = getTinyMemory();
+                Input *input = newInput();
                 input->type = WINDOW_RESIZE;
                 input->x = e.window.data1;
                 input->y = e.window.data2;
@@ -614,263 +569,186 @@ static bool handleEvents(void) {
 }
 
 
-static void *getTinyMemory(void) {
-    while (axs.len(tinyPool) > 1000000)
-        axs.destroyItem(tinyPool, axs.pop(tinyPool));
-    if (axs.len(tinyPool) != 0)
-        return axs.pop(tinyPool);
-
-    for (int i = 0; i < 16; ++i) {
-        void *p = malloc(MAX(sizeof(Input), sizeof(Square)));
-        if (!p || axs.push(tinyPool, p)) {
-            fprintf(stderr, "Tiny memory pool ran out of memory.\n");
-            abort();
+// feed an event to the rule prompt; return true if the event was consumed
+static bool typeRule(const SDL_Event *e) {
+    if (e->type == SDL_TEXTINPUT) {
+        strncat(ruleInput, e->text.text, sizeof ruleInput - strlen(ruleInput) - 1);
+    } else if (e->type == SDL_KEYDOWN) {
+        switch (e->key.keysym.sym) {
+        case SDLK_RETURN:
+        case SDLK_KP_ENTER: {
+            Input *input = newInput();
+            input->type = RULE;
+            axq.enqueue(inputs, input);
+            typingRule = false;
+            break;
         }
+        case SDLK_ESCAPE:
+            typingRule = false;
+            break;
+        case SDLK_BACKSPACE:
+            if (*ruleInput)
+                ruleInput[strlen(ruleInput) - 1] = '\0';
+            break;
+        }
+    } else {
+        return false;
     }
 
-    return axs.pop(tinyPool);
-}
-
-
-static void destructSquare(void *s) {
-    if (s) axs.push(tinyPool, s);
-}
-
-
-static void destructInput(void *i) {
-    if (i) axs.push(tinyPool, i);
-}
-
-
-static void destructSnapshot(void *v) {
-    if (v) axv_destroy(v);
-}
-
-
-static void destructTemporary(void *t) {
-    if (t) axs.push(tinyPool, t);
-}
-
-
-static int compareSquares(const void *a, const void *b) {
-    const Square *s1 = *(Square **) a;
-    const Square *s2 = *(Square **) b;
-    const int xOrder = (s1->x > s2->x) - (s1->x < s2->x);
-    if (xOrder) return xOrder;
-    return (s1->y > s2->y) - (s1->y < s2->y);
-}
-
-
-static bool filterEqualSquares(const void *s, void *arg) {
-    return compareSquares(&s, &arg);
-}
-
-
-static void *mapNewSquares(void *square) {
-    Square *s1 = square;
-    Square *s2 = getTinyMemory();
-    *s2 = *s1;
-    return s2;
+    char title[sizeof ruleInput + 32];
+    snprintf(title, sizeof title, "Game of Life - new rule: %s", ruleInput);
+    if (typingRule)
+        SDL_SetWindowTitle(window, title);
+    else
+        *statusTitle = '\0';   // showStatus() restores the title
+    return true;
 }
 
 
-/* PRE-CONDITION: vector is sorted! */
-static bool removeDuplicates(const void *current, void *args_) {
-    struct args_removeDuplicates *args = args_;
+// show the batch size and speed of hyperspeed mode in the window title, unless a rule is being typed
+static void showStatus(const Frame *frame) {
+    char title[sizeof statusTitle];
+    if (frame->batch)
+        snprintf(title, sizeof title, "Game of Life - hyperspeed: 2^%d generations per frame, %.0f generations/s",
+                 __builtin_ctzll(frame->batch), frame->gensPerSec);
+    else
+        snprintf(title, sizeof title, "Game of Life");
 
-    if (args->origin && args->comp(&args->origin, &current) == 0) {
-        return false;
-    } else {
-        args->origin = (void *) current;
-        return true;
+    if (!typingRule && strcmp(title, statusTitle)) {
+        SDL_SetWindowTitle(window, title);
+        strcpy(statusTitle, title);
     }
 }
 
 
-static void loadPlaintextPattern(const char *s) {
-    while (*s && *s == '!') {
-        while (*s && *s != '\n')
-            ++s;
-        s += !!*s;
-    }
-
-    for (Sint64 x = 0, y = 0; *s; ++s, ++x) {
-        if (*s == '.')
-            continue;
-        if (*s == '\r')
-            continue;
-        if (*s == '\n') {
-            x = -1;
-            ++y;
-            continue;
-        }
-        if (*s == 'O') {
-            Square *square = getTinyMemory();
-            square->x = (double) x;
-            square->y = (double) y;
-            axv_push(squares, square);
+// draw text in the embedded bitmap font with its top left corner at (x, y), scaled up by scale
+static void drawText(int x, int y, int scale, const char *text) {
+    SDL_Rect pixels[FONT_WIDTH * FONT_HEIGHT];
+    for (; *text; ++text, x += (FONT_WIDTH + 1) * scale) {
+        const Uint16 glyph = font_glyph(*text);
+        int count = 0;
+        for (int row = 0; row < FONT_HEIGHT; ++row) {
+            for (int col = 0; col < FONT_WIDTH; ++col) {
+                if (glyph >> (3 * (FONT_HEIGHT - 1 - row) + FONT_WIDTH - 1 - col) & 1)
+                    pixels[count++] = (SDL_Rect) {x + col * scale, y + row * scale, scale, scale};
+            }
         }
+        SDL_RenderFillRects(renderer, pixels, count);
     }
 }
 
 
-static char *loadRLEPattern(const char *s) {
-    while (*s && *s == '#') {
-        while (*s && *s != '\n')
-            ++s;
-        s += !!*s;
-    }
+static void formatDuration(char *s, size_t n, Uint64 ns) {
+    if (ns < 1000)
+        snprintf(s, n, "%lluns", (unsigned long long) ns);
+    else if (ns < 1000000)
+        snprintf(s, n, "%.1fus", (double) ns / 1e3);
+    else if (ns < 1000000000)
+        snprintf(s, n, "%.1fms", (double) ns / 1e6);
+    else
+        snprintf(s, n, "%.2fs", (double) ns / 1e9);
+}
 
-    Uint64 w = 0, h = 0;
-    for (Uint64 *fill = &w; *s && *s != '\n'; ++s) {
-        if (!isdigit(*s))
-            continue;
 
-        errno = 0;
-        char *tmp;
-        *fill = strtoull(s, &tmp, 10);
-        if (errno) return NULL;
-        s = tmp - 1;
-        if (fill == &h) break;
-        fill = &h;
-    }
+// a line per phase timed so far: statistics of its latest samples and a histogram of their durations
+// from 64 ns (left) to 1 s (right), each bar twice the duration of the one to its left
+static void drawHud(void) {
+    enum {SCALE = 2, LINE = (FONT_HEIGHT + 3) * SCALE, CHAR = (FONT_WIDTH + 1) * SCALE, FIRST_BUCKET = 6, BARS = 24};
+    const int columns = 78, histogramX = 8 + columns * CHAR;
 
-    char *rulestring = NULL;
-    while (*s != '\n') {
-        if (*s == '=') {
-            do ++s; while (*s != '\n' && isspace(*s));
-            if (*s == '\n') break;
-            const char *start = s;
-            const char *end = strchr(s, '\n');
-            rulestring = malloc(end - start);
-            memcpy(rulestring, start, end - start - 1);
-            rulestring[end - start] = '\0';
-        }
-        ++s;
+    ProfileStats stats[PROF_PHASES];
+    int lines = 1;
+    for (ProfilePhase p = 0; p < PROF_PHASES; ++p) {
+        prof_stats(p, &stats[p]);
+        lines += stats[p].samples != 0;
     }
 
-    enum States {COUNT, TAG};
-    enum States state = COUNT;
-    for (Sint64 x = 0, y = 0, count = 0; *s && *s != '!'; ++s) {
-        if (isspace(*s))
-            continue;
-
-        if (state == COUNT) {
-            if (isdigit(*s)) {
-                int digit = *s - '0';
-                count = count * 10 + digit;
-            } else {
-                count += !count;
-                state = TAG;
-                --s;
-            }
-        }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xC0);
+    SDL_RenderFillRect(renderer, &(SDL_Rect) {0, 0, histogramX + BARS * 3 * SCALE + 8, lines * LINE + 8});
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, SDL_ALPHA_OPAQUE);
 
-        else /*if (state == TAG)*/ {
-            if (*s == 'b') {
-                x += count;
-            } else if (*s == '$') {
-                x = 0;
-                y += count;
-            } else if (*s == 'o') {
-                while (count--) {
-                    Square *square = getTinyMemory();
-                    square->x = (double) x++;
-                    square->y = (double) y;
-                    axv_push(squares, square);
-                }
-            }
+    char line[96];
+    snprintf(line, sizeof line, "%-9s%10s%9s%9s%9s%6s%8s%8s%8s", "phase", "samples", "mean", "p99", "max",
+             "ipc", "l1/u", "llc/u", "br/u");
+    drawText(8, 8, SCALE, line);
+    int y = 8 + LINE;
+    for (ProfilePhase p = 0; p < PROF_PHASES; ++p) {
+        const ProfileStats *st = &stats[p];
+        if (!st->samples)
+            continue;
 
-            count = 0;
-            state = COUNT;
-        }
+        char mean[16], p99[16], max[16];
+        formatDuration(mean, sizeof mean, st->meanNs);
+        formatDuration(p99, sizeof p99, st->p99Ns);
+        formatDuration(max, sizeof max, st->maxNs);
+        // hardware events of the window, per cell update; "-" where they were not counted
+        char ipc[16] = "-", perUnit[3][16] = {"-", "-", "-"};
+        const ProfileEvent events[3] = {PROF_L1_MISSES, PROF_LLC_MISSES, PROF_BRANCH_MISSES};
+        if (prof_ipc(&st->window) >= 0)
+            snprintf(ipc, sizeof ipc, "%.2f", prof_ipc(&st->window));
+        for (int e = 0; e < 3; ++e) {
+            if (st->available[events[e]] && prof_perUnit(&st->window, events[e]) >= 0)
+                snprintf(perUnit[e], sizeof perUnit[e], "%.3f", prof_perUnit(&st->window, events[e]));
+        }
+        snprintf(line, sizeof line, "%-9s%10llu%9s%9s%9s%6s%8s%8s%8s", prof_name(p), (unsigned long long) st->count,
+                 mean, p99, max, ipc, perUnit[0], perUnit[1], perUnit[2]);
+        drawText(8, y, SCALE, line);
+
+        Uint32 highest = 1;
+        for (int b = 0; b < BARS; ++b)
+            highest = st->histogram[FIRST_BUCKET + b] > highest ? st->histogram[FIRST_BUCKET + b] : highest;
+        for (int b = 0; b < BARS; ++b) {
+            const int h = (int) ((Uint64) st->histogram[FIRST_BUCKET + b] * (LINE - SCALE) / highest);
+            SDL_RenderFillRect(renderer, &(SDL_Rect) {histogramX + b * 3 * SCALE, y + FONT_HEIGHT * SCALE - h, 2 * SCALE, h});
+        }
+        y += LINE;
     }
-
-    return rulestring;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 }
 
 
-static int cmpUint8(const void *a, const void *b) {
-    const Uint8 x = **(const Uint8 **) a;
-    const Uint8 y = **(const Uint8 **) b;
-    return (x > y) - (x < y);
-}
-
-
-static void initSingleRule(axvector *nums, struct SingleRule *r) {
-    struct args_removeDuplicates argsrd = {axv_getComparator(nums), NULL};
-    axv_filter(axv_sort(nums), removeDuplicates, &argsrd);
-    if (axv_count(nums, &(Uint8) {9}))
-        axv_discard(nums, 1);
-
-    bool isRange = true;
-    for (axvsnap q = axv_snapshot(nums); q.i < q.len - 1; ++q.i) {
-        Uint8 *x = q.vec[q.i];
-        Uint8 *y = q.vec[q.i + 1];
-        if (*x + 1 != *y) {
-            isRange = false;
-            break;
-        }
-    }
+// append a row for every phase timed since the previous call
+static void writeProfile(void) {
+    ProfileMark now;
+    prof_mark(&now);
+    const double seconds = (double) (now.ns - profileStart) / 1e9;
+    for (ProfilePhase p = 0; p < PROF_PHASES; ++p) {
+        ProfileStats stats;
+        prof_stats(p, &stats);
+        if (stats.count == csvCounts[p])
+            continue;
 
-    if (isRange) {
-        r->nums[0] = *(Uint8 *) axv_at(nums, 0);
-        r->nums[1] = *(Uint8 *) axv_at(nums, -1);
-        r->isRange = true;
-        r->len = 2;
-    } else {
-        axv_reverse(nums);
-        r->len = axv_len(nums);
-        r->isRange = false;
-        for (int i = 0; axv_len(nums); ++i, axv_discard(nums, 1))
-            r->nums[i] = *(Uint8 *) axv_top(nums);
+        fprintf(profileCSV, "%.6f,%s,%llu,%llu,%llu,%llu,%llu\n", seconds, prof_name(p),
+                (unsigned long long) (stats.count - csvCounts[p]), (unsigned long long) (stats.totalNs - csvTotals[p]),
+                (unsigned long long) stats.p50Ns, (unsigned long long) stats.p99Ns, (unsigned long long) stats.maxNs);
+        csvCounts[p] = stats.count;
+        csvTotals[p] = stats.totalNs;
     }
-
-    axv_clear(nums);
 }
 
 
-static Rules parseRulestring(const char *s) {
-    axvector *nums = axv_setDestructor(axv_setComparator(axv_sizedNew(10), cmpUint8), destructTemporary);
-    Rules r;
-
-    // currently only doing B/S notation starting at 'B'
-    ++s;
-    for (int i = 0; isdigit(*s); ++i, ++s) {
-        Uint8 *d = getTinyMemory();
-        *d = *s - '0';
-        axv_push(nums, d);
-    }
-
-    if (axv_len(nums)) {
-        initSingleRule(nums, &r.birth);
-    } else {
-        r.birth.nums[0] = 3;
-        r.birth.nums[1] = 3;
-        r.birth.isRange = true;
-        r.birth.len = 2;
+// write the events held by the trace buffers, replacing the trace written before
+static void writeTrace(void) {
+    FILE *f = fopen(traceFile, "w");
+    if (!f) {
+        fprintf(stderr, "Could not open \"%s\" for writing.\n", traceFile);
+        return;
     }
+    const bool failed = trace_write(f);
+    if (fclose(f) || failed)
+        fprintf(stderr, "Could not write the trace to \"%s\".\n", traceFile);
+    else
+        printf("Wrote the trace to \"%s\".\n", traceFile);
+}
 
-    while (*s && *s != 'S' && *s != 's') ++s;
-
-    s += !!*s;
-    for (int i = 0; isdigit(*s); ++i, ++s) {
-        Uint8 *d = getTinyMemory();
-        *d = *s - '0';
-        axv_push(nums, d);
-    }
 
-    if (axv_len(nums)) {
-        initSingleRule(nums, &r.survival);
-    } else {
-        r.survival.nums[0] = 2;
-        r.survival.nums[1] = 3;
-        r.survival.isRange = true;
-        r.birth.len = 2;
+static Input *newInput(void) {
+    Input *input = ar_alloc(inputArena, sizeof *input);
+    if (!input) {
+        fprintf(stderr, "Could not allocate memory for an input.\n");
+        abort();
     }
-
-    axv_destroy(nums);
-    return r;
+    return input;
 }
 
-
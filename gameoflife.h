@@ -6,6 +6,7 @@
 #define GAMEOFLIFE_GAMEOFLIFE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 enum {
     GOL_defaultWindowWidth = 1024,
@@ -28,10 +29,34 @@ struct GOL_Pattern {
     bool freeRulestring;
 };
 
+struct GOL_Options {
+    const char *engine;     // name of the simulation engine; NULL for the default
+    unsigned memoryBudget;  // MiB the engine may use for caches; 0 for the engine's default
+    unsigned threads;       // threads stepping the world in parallel (tile, dense and sortcount engines); 0 or 1 for none
+    const char *topology;   // bounded universe such as T:640x480, see engine_parseTopology(); NULL for an infinite plane
+    const char *profile;    // CSV file the phase timings are streamed to in windowed mode; NULL for none
+    bool counters;          // add hardware counters to the profiler, if the system permits them
+    const char *trace;      // file a Chrome trace event timeline is written to on exit (and F4); NULL for none
+};
+
 /*
  * Start an instance of the Game of Life.
  * Supply custom window dimensions and an initial game tick rate or just use the defaults.
  * You may pass a pattern or set it to NULL if no pattern shall be loaded.
+ * The options select how the world is simulated; zero-initialise them to use the defaults.
+ * A bounded topology (plane, torus or Klein bottle) is always simulated by the dense engine.
+ * Generations rules with more than two states are only simulated by the tile engine, which
+ * replaces any other engine in that case; dying cells are drawn in fading colours.
+ * Once the world settles into a periodic state, the generation it stabilised at and its period
+ * are printed to stdout and from then on only a remainder of each full cycle is computed.
+ * The world is simulated on a thread of its own, so a slow generation does not hold up input or
+ * drawing; edits take effect between generations.
+ * If options.profile is set, the timings of the profiler are appended to that CSV file once per frame:
+ * for every phase timed since the previous row, the samples and total ns since then as well as the
+ * median, 99th percentile and maximum ns of its latest PROF_SAMPLES samples.
+ * If options.trace is set, the frames of the front end and the generations and frames published by
+ * the simulation thread are traced, and the latest TRACE_EVENTS events of every thread are written to
+ * that file as Chrome trace event JSON on exit and whenever F4 is pressed.
  *
  * Controls:
  * ENTER / P                - Pause or resume the game. The game is paused at start.
@@ -47,11 +72,30 @@ struct GOL_Pattern {
  * BACKSPACE                - Clear the world.
  * Q                        - Decrease tick rate by 1; 10 when holding SHIFT, 100 when holding CTRL.
  * E                        - Increase tick rate by 1; 10 when holding SHIFT, 100 when holding CTRL.
+ *                            Engines able to jump (hashlife) advance by the largest power of two due at once.
+ * H                        - Toggle hyperspeed: 2^k generations per frame, k adapting so that a frame
+ *                            stays within its time budget. Generations per second are shown in the title.
+ * F3                       - Toggle the profiler HUD: rolling statistics and histograms of the time spent in
+ *                            every phase of a generation (sorted engine) and of a frame.
+ * F4                       - Write the trace, if tracing.
  * B                        - Store a snapshot of the game state.
  * R                        - Restore the most recently stored game state snapshot.
+ * TAB                      - Type a new rulestring; ENTER applies it, ESCAPE cancels.
+ *                            Hensel notation for isotropic rules is understood, e.g. B2-a/S12.
  * Number keys              - Switch between available cell textures.
  * ESCAPE                   - Exit game.
  */
-void gameOfLife(int w, int h, unsigned tickrate, struct GOL_Pattern patinfo);
+void gameOfLife(int w, int h, unsigned tickrate, struct GOL_Pattern patinfo, struct GOL_Options options);
+
+/*
+ * Run the Game of Life without a window: load the pattern, advance it by gens generations as fast
+ * as the engine allows and write the result to stdout as an RLE pattern. Comment lines in front of
+ * the pattern report the elapsed time, generations and live cells advanced per second, the peak
+ * population and the heap allocations made while stepping, with the last generation that needed
+ * one. With options.counters, the IPC and the cache and branch misses per cell update of every
+ * phase profiled are reported as well; with options.trace, a timeline of the generations is
+ * written to that file. Returns the exit status for main().
+ */
+int gameOfLifeHeadless(struct GOL_Pattern patinfo, struct GOL_Options options, uint64_t gens);
 
 #endif //GAMEOFLIFE_GAMEOFLIFE_H
@@ -0,0 +1,354 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "gol.h"
+#include "engine.h"
+#include "pattern.h"
+#include "period.h"
+#include "profile.h"
+#include "trace.h"
+#include "tilekernel.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct GOL_Universe {
+    const struct GOL_Engine *engine;
+    void *world;
+    Rules rules;
+    char *rulestring;
+    uint64_t generation;
+    PeriodTracker period;
+    bool detectPeriods;
+};
+
+struct GOL_Cells {
+    cellset *layers[RULES_MAX_STATES];
+    char *rules;        // NULL if unknown
+};
+
+// callback of gol_forEachInRect() and its argument
+typedef struct Visitor {
+    void (*f)(int32_t, int32_t, unsigned, void *);
+    void *arg;
+} Visitor;
+
+
+static char *copyString(const char *s) {
+    char *copy = heap_malloc(strlen(s) + 1);
+    if (!copy) {
+        fprintf(stderr, "Could not allocate memory for a string.\n");
+        abort();
+    }
+    return strcpy(copy, s);
+}
+
+
+GOL_Universe *gol_create(const GOL_Settings *settings) {
+    const struct GOL_Engine *engine = engine_find(settings->engine);
+    if (!engine) {
+        fprintf(stderr, "Unknown engine \"%s\", using \"%s\" instead.\n", settings->engine, engine_find(NULL)->name);
+        engine = engine_find(NULL);
+    }
+
+    EngineConfig config = {
+            .memoryBudget = settings->memoryBudget,
+            .threads = settings->threads
+    };
+    if (settings->topology && engine_parseTopology(&config.topology, settings->topology))
+        fprintf(stderr, "Invalid topology \"%s\", using an infinite plane instead.\n", settings->topology);
+    if (config.topology.type != TOPOLOGY_INFINITE && engine != &denseEngine) {
+        if (settings->engine)
+            fprintf(stderr, "Engine \"%s\" only supports an infinite plane, using \"%s\" instead.\n", engine->name, denseEngine.name);
+        engine = &denseEngine;
+    } else if (config.topology.type == TOPOLOGY_INFINITE && engine == &denseEngine) {
+        fprintf(stderr, "Engine \"%s\" needs a bounded topology, using \"%s\" instead.\n", engine->name, engine_find(NULL)->name);
+        engine = engine_find(NULL);
+    }
+
+    const char *rulestring = settings->rules ? settings->rules : "B3/S23";
+    if (rules_parse(&config.rules, rulestring)) {
+        fprintf(stderr, "Invalid rulestring \"%s\", using B3/S23 instead.\n", rulestring);
+        rulestring = "B3/S23";
+        rules_parse(&config.rules, rulestring);
+    }
+    if (config.rules.states > 2 && !engine->setState) {
+        fprintf(stderr, "Engine \"%s\" only supports two states, using \"%s\" on an infinite plane instead.\n",
+                engine->name, tileEngine.name);
+        engine = &tileEngine;
+        config.topology.type = TOPOLOGY_INFINITE;
+    }
+
+    GOL_Universe *u = heap_calloc(1, sizeof *u);
+    if (!u) return NULL;
+    u->world = engine->create(&config);
+    if (!u->world) {
+        free(u);
+        return NULL;
+    }
+
+    u->engine = engine;
+    u->rules = config.rules;
+    u->rulestring = copyString(rulestring);
+    u->detectPeriods = settings->detectPeriods;
+    period_reset(&u->period);
+    return u;
+}
+
+
+void gol_destroy(GOL_Universe *u) {
+    if (!u) return;
+    u->engine->destroy(u->world);
+    free(u->rulestring);
+    free(u);
+}
+
+
+const char *gol_engineName(const GOL_Universe *u) {
+    return u->engine->name;
+}
+
+
+const char *gol_rules(const GOL_Universe *u) {
+    return u->rulestring;
+}
+
+
+unsigned gol_states(const GOL_Universe *u) {
+    return u->rules.states;
+}
+
+
+bool gol_setRules(GOL_Universe *u, const char *rulestring) {
+    Rules rules;
+    if (rules_parse(&rules, rulestring)) {
+        fprintf(stderr, "Invalid rulestring \"%s\", keeping the current rules.\n", rulestring);
+        return true;
+    }
+    if (rules.states > 2 && !u->engine->setState) {
+        fprintf(stderr, "Engine \"%s\" only supports two states, keeping the current rules.\n", u->engine->name);
+        return true;
+    }
+
+    u->engine->setRules(u->world, &rules);
+    u->rules = rules;
+    free(u->rulestring);
+    u->rulestring = copyString(rulestring);
+    period_reset(&u->period);
+    return false;
+}
+
+
+uint64_t gol_advance(GOL_Universe *u, uint64_t gens) {
+    if (!gens)
+        return 0;
+
+    // cell updates are only counted while profiling, as the population is not free for every engine
+    const uint64_t population = prof_enabled() ? u->engine->population(u->world) : 0;
+    ProfileMark start, end;
+    trace_begin("advance");
+    prof_mark(&start);
+    // the generation stepped from is recorded here rather than on every reset, so that a burst of edits
+    // does not hash the world once per cell; a world periodic from the start is then caught at once
+    const bool detect = u->detectPeriods && u->engine->hash;
+    if (detect && !u->period.period && (!u->period.observed || u->period.generation != u->generation))
+        period_observe(&u->period, u->generation, u->engine->hash(u->world));
+    uint64_t advanced = 1;
+    if (u->period.period) {
+        // a periodic world only needs the generations past the last full cycle computed
+        for (uint64_t i = period_reduce(&u->period, gens); i; --i)
+            u->engine->step(u->world);
+        advanced = gens;
+    } else if (u->engine->jump && gens > 1) {
+        // engines that can jump ahead take all due generations at once
+        advanced = u->engine->jump(u->world, gens);
+    } else {
+        u->engine->step(u->world);
+    }
+
+    u->generation += advanced;
+    if (detect)
+        period_observe(&u->period, u->generation, u->engine->hash(u->world));
+    prof_mark(&end);
+    prof_record(PROF_ADVANCE, &start, &end, population * advanced);
+    trace_end("advance");
+    return advanced;
+}
+
+
+void gol_step(GOL_Universe *u, uint64_t gens) {
+    while (gens)
+        gens -= gol_advance(u, gens);
+}
+
+
+uint64_t gol_generation(const GOL_Universe *u) {
+    return u->generation;
+}
+
+
+void gol_setGeneration(GOL_Universe *u, uint64_t generation) {
+    u->generation = generation;
+}
+
+
+bool gol_period(const GOL_Universe *u, uint64_t *period, uint64_t *since) {
+    if (period) *period = u->period.period;
+    if (since) *since = u->period.stableSince;
+    return u->period.period;
+}
+
+
+void gol_setCell(GOL_Universe *u, int32_t x, int32_t y, unsigned state) {
+    if (state >= u->rules.states)
+        state = 0;
+    if (u->engine->setState)
+        u->engine->setState(u->world, cell_make(x, y), (uint8_t) state);
+    else
+        u->engine->setCell(u->world, cell_make(x, y), state != 0);
+    period_reset(&u->period);
+}
+
+
+void gol_clear(GOL_Universe *u) {
+    u->engine->clear(u->world);
+    period_reset(&u->period);
+}
+
+
+static void visitLive(Cell c, void *visitor) {
+    const Visitor *v = visitor;
+    v->f(cell_x(c), cell_y(c), 1, v->arg);
+}
+
+
+static void visitState(Cell c, uint8_t state, void *visitor) {
+    const Visitor *v = visitor;
+    v->f(cell_x(c), cell_y(c), state, v->arg);
+}
+
+
+void gol_forEachInRect(GOL_Universe *u, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                       void (*f)(int32_t, int32_t, unsigned, void *), void *arg) {
+    const CellRect r = {x0, y0, x1, y1};
+    Visitor v = {f, arg};
+    if (u->rules.states > 2)
+        u->engine->forEachStateInRect(u->world, &r, visitState, &v);
+    else
+        u->engine->forEachInRect(u->world, &r, visitLive, &v);
+}
+
+
+uint64_t gol_population(GOL_Universe *u) {
+    return u->engine->population(u->world);
+}
+
+
+bool gol_hash(GOL_Universe *u, uint64_t *hash) {
+    if (!u->engine->hash)
+        return false;
+    *hash = u->engine->hash(u->world);
+    return true;
+}
+
+
+bool gol_memory(GOL_Universe *u, GOL_MemoryStats *stats) {
+    if (!u->engine->arenaStats)
+        return false;
+    ArenaStats a;
+    u->engine->arenaStats(u->world, &a);
+    *stats = (GOL_MemoryStats) {a.allocations, a.frees, a.resets, a.slabs, a.reserved, a.inUse, a.peakInUse};
+    return true;
+}
+
+
+uint64_t gol_allocations(void) {
+    return heap_allocations();
+}
+
+
+bool gol_writeRLE(GOL_Universe *u, FILE *f) {
+    return pattern_writeRLE(f, u->engine, u->world, &u->rules, u->rulestring);
+}
+
+
+const char *gol_tileKernel(void) {
+    const char *name;
+    tileKernel_select(&name);
+    return name;
+}
+
+
+GOL_Cells *gol_newCells(void) {
+    GOL_Cells *cells = heap_calloc(1, sizeof *cells);
+    if (!cells) {
+        fprintf(stderr, "Could not allocate memory for a cell collection.\n");
+        abort();
+    }
+    return cells;
+}
+
+
+GOL_Cells *gol_readRLE(const char *text) {
+    GOL_Cells *cells = gol_newCells();
+    cells->rules = pattern_loadRLE(text, cells->layers);
+    return cells;
+}
+
+
+GOL_Cells *gol_readPlaintext(const char *text) {
+    GOL_Cells *cells = gol_newCells();
+    pattern_loadPlaintext(text, cells->layers);
+    return cells;
+}
+
+
+static void collectLive(Cell c, void *cells) {
+    cs_push(pattern_layer(cells, 1), c);
+}
+
+
+static void collectState(Cell c, uint8_t state, void *cells) {
+    cs_push(pattern_layer(cells, state), c);
+}
+
+
+GOL_Cells *gol_capture(GOL_Universe *u) {
+    GOL_Cells *cells = gol_newCells();
+    cells->rules = copyString(u->rulestring);
+    cells->layers[1] = cs_sizedNew(u->engine->population(u->world));
+
+    const CellRect everything = {INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX};
+    if (u->rules.states > 2)
+        u->engine->forEachStateInRect(u->world, &everything, collectState, cells->layers);
+    else
+        u->engine->forEachInRect(u->world, &everything, collectLive, cells->layers);
+    return cells;
+}
+
+
+void gol_freeCells(GOL_Cells *cells) {
+    if (!cells) return;
+    pattern_destroyLayers(cells->layers);
+    free(cells->rules);
+    free(cells);
+}
+
+
+void gol_addCell(GOL_Cells *cells, int32_t x, int32_t y, unsigned state) {
+    if (state && state < RULES_MAX_STATES)
+        cs_push(pattern_layer(cells->layers, state), cell_make(x, y));
+}
+
+
+const char *gol_cellsRules(const GOL_Cells *cells) {
+    return cells->rules;
+}
+
+
+void gol_load(GOL_Universe *u, const GOL_Cells *cells) {
+    // pattern_addToWorld() does not modify the layers
+    pattern_addToWorld(u->engine, u->world, (cellset **) cells->layers);
+    period_reset(&u->period);
+}
@@ -0,0 +1,238 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_GOL_H
+#define GAMEOFLIFE_GOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * libgameoflife: the simulation without any front end. A universe is an opaque handle owning
+ * a world and the engine computing it; cells are addressed by their 32-bit coordinates and
+ * carry a state, which is 0 for dead and 1 for live cells, or the dying states 2 and up under
+ * Generations rules. Cell collections (GOL_Cells) hold patterns read from files or captured
+ * from a universe until they are loaded into one.
+ */
+typedef struct GOL_Universe GOL_Universe;
+typedef struct GOL_Cells GOL_Cells;
+
+// how a universe is set up; zero-initialise for the defaults
+typedef struct GOL_Settings {
+    const char *engine;     // sorted, hash, tile, hashlife, dense, sweep or sortcount; NULL for the default
+    const char *rules;      // rulestring; NULL for B3/S23
+    const char *topology;   // bounded universe such as T:640x480; NULL for an infinite plane
+    unsigned threads;       // threads stepping the world in parallel; 0 or 1 for none
+    uint64_t memoryBudget;  // bytes the engine may use for caches; 0 for the engine's default
+    bool detectPeriods;     // fast-forward the world once it is periodic, see gol_period()
+} GOL_Settings;
+
+// how an engine allocating its world from a slab arena uses it, see gol_memory()
+typedef struct GOL_MemoryStats {
+    uint64_t allocations;   // objects allocated since creation
+    uint64_t frees;         // objects freed one by one
+    uint64_t resets;        // times all objects were freed at once
+    uint64_t slabs;         // slabs held
+    uint64_t reserved;      // bytes held
+    uint64_t inUse;         // bytes of the objects allocated
+    uint64_t peakInUse;     // largest inUse seen
+} GOL_MemoryStats;
+
+/**
+ * Create a universe. Invalid settings are reported to stderr and replaced by defaults; the engine
+ * is replaced if it cannot handle the rules or topology, see gol_engineName().
+ * @param settings settings
+ * @return new universe or NULL if it could not be created
+ */
+GOL_Universe *gol_create(const GOL_Settings *settings);
+
+/**
+ * Destroy a universe. NULL is ignored.
+ * @param u universe
+ */
+void gol_destroy(GOL_Universe *u);
+
+/**
+ * @param u universe
+ * @return name of the engine computing the universe
+ */
+const char *gol_engineName(const GOL_Universe *u);
+
+/**
+ * @param u universe
+ * @return rulestring of the current rules
+ */
+const char *gol_rules(const GOL_Universe *u);
+
+/**
+ * @param u universe
+ * @return number of cell states of the current rules; 2 for life-like rules
+ */
+unsigned gol_states(const GOL_Universe *u);
+
+/**
+ * Replace the rules, keeping the cells. Changing the number of states drops all dying cells.
+ * @param u universe
+ * @param rulestring new rules
+ * @return true if the rulestring is invalid or the engine cannot handle the rules; the reason is reported to stderr
+ */
+bool gol_setRules(GOL_Universe *u, const char *rulestring);
+
+/**
+ * Advance by at most gens generations in one go. Engines able to jump take large strides,
+ * periodic universes take all gens at once if periods are detected.
+ * @param u universe
+ * @param gens generations due
+ * @return generations advanced; at least 1 unless gens is 0
+ */
+uint64_t gol_advance(GOL_Universe *u, uint64_t gens);
+
+/**
+ * Advance by exactly gens generations.
+ * @param u universe
+ * @param gens generations
+ */
+void gol_step(GOL_Universe *u, uint64_t gens);
+
+/**
+ * @param u universe
+ * @return generations advanced since creation, or the generation set last
+ */
+uint64_t gol_generation(const GOL_Universe *u);
+
+/**
+ * Set the generation counter, e.g. when restoring a snapshot.
+ * @param u universe
+ * @param generation generation
+ */
+void gol_setGeneration(GOL_Universe *u, uint64_t generation);
+
+/**
+ * Whether the universe is known to be periodic. Only detected if the settings ask for it.
+ * @param u universe
+ * @param period if not NULL, receives the period
+ * @param since if not NULL, receives the generation the universe stabilised at
+ * @return true if the universe is periodic
+ */
+bool gol_period(const GOL_Universe *u, uint64_t *period, uint64_t *since);
+
+/**
+ * Set the state of a cell. States the rules do not have are taken as 0.
+ * @param u universe
+ * @param x, y coordinates
+ * @param state new state
+ */
+void gol_setCell(GOL_Universe *u, int32_t x, int32_t y, unsigned state);
+
+/**
+ * Kill every cell.
+ * @param u universe
+ */
+void gol_clear(GOL_Universe *u);
+
+/**
+ * Call f for every cell in a state other than 0 within the inclusive bounds; cells may be visited in any order.
+ * @param u universe
+ * @param x0, y0, x1, y1 inclusive bounds
+ * @param f callback receiving the coordinates and state of a cell
+ * @param arg argument passed to f
+ */
+void gol_forEachInRect(GOL_Universe *u, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                       void (*f)(int32_t x, int32_t y, unsigned state, void *arg), void *arg);
+
+/**
+ * @param u universe
+ * @return number of live cells
+ */
+uint64_t gol_population(GOL_Universe *u);
+
+/**
+ * Hash of the cells, equal for equal universes no matter which engine computes them.
+ * @param u universe
+ * @param hash receives the hash
+ * @return false if the engine does not keep track of a hash
+ */
+bool gol_hash(GOL_Universe *u, uint64_t *hash);
+
+/**
+ * Memory statistics of the engine, if it allocates its world from a slab arena (tile).
+ * @param u universe
+ * @param stats receives the statistics
+ * @return false if the engine does not keep any
+ */
+bool gol_memory(GOL_Universe *u, GOL_MemoryStats *stats);
+
+/**
+ * @return heap allocations made by the library since the process started, by any thread
+ */
+uint64_t gol_allocations(void);
+
+/**
+ * Write the cells of the universe as an RLE pattern.
+ * @param u universe
+ * @param f output file
+ * @return true if writing failed
+ */
+bool gol_writeRLE(GOL_Universe *u, FILE *f);
+
+/**
+ * @return name of the instruction set the tile kernels of this machine use
+ */
+const char *gol_tileKernel(void);
+
+/**
+ * @return new empty cell collection
+ */
+GOL_Cells *gol_newCells(void);
+
+/**
+ * Read an RLE pattern, including multi-state RLE.
+ * @param text pattern file contents
+ * @return new cell collection
+ */
+GOL_Cells *gol_readRLE(const char *text);
+
+/**
+ * Read a plaintext pattern.
+ * @param text pattern file contents
+ * @return new cell collection
+ */
+GOL_Cells *gol_readPlaintext(const char *text);
+
+/**
+ * Copy every cell of a universe, together with its rulestring.
+ * @param u universe
+ * @return new cell collection
+ */
+GOL_Cells *gol_capture(GOL_Universe *u);
+
+/**
+ * Free a cell collection. NULL is ignored.
+ * @param cells cell collection
+ */
+void gol_freeCells(GOL_Cells *cells);
+
+/**
+ * Add a cell to a collection.
+ * @param cells cell collection
+ * @param x, y coordinates
+ * @param state state other than 0
+ */
+void gol_addCell(GOL_Cells *cells, int32_t x, int32_t y, unsigned state);
+
+/**
+ * @param cells cell collection
+ * @return rulestring of the pattern the cells were read or captured from, NULL if there is none
+ */
+const char *gol_cellsRules(const GOL_Cells *cells);
+
+/**
+ * Add the cells of a collection to a universe. Dying states are skipped if the rules have none.
+ * @param u universe
+ * @param cells cell collection
+ */
+void gol_load(GOL_Universe *u, const GOL_Cells *cells);
+
+#endif //GAMEOFLIFE_GOL_H
@@ -0,0 +1,109 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#define _POSIX_C_SOURCE 200809L
+#include "gameoflife.h"
+#include "world.h"
+#include "profile.h"
+#include "trace.h"
+#include <stdio.h>
+#include <time.h>
+
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+
+// a line per phase counted: IPC and the events per cell update over the whole run
+static void printCounters(void) {
+    for (ProfilePhase p = 0; p < PROF_PHASES; ++p) {
+        ProfileStats stats;
+        prof_stats(p, &stats);
+        if (!stats.all.samples)
+            continue;
+
+        printf("#C Phase %s: %llu samples", prof_name(p), (unsigned long long) stats.all.samples);
+        if (stats.available[PROF_CYCLES] && stats.available[PROF_INSTRUCTIONS])
+            printf(", IPC %.2f", prof_ipc(&stats.all));
+        for (ProfileEvent e = PROF_L1_MISSES; e < PROF_EVENTS; ++e) {
+            if (stats.available[e] && stats.all.units)
+                printf(", %s/update %.4f", prof_eventName(e), prof_perUnit(&stats.all, e));
+        }
+        putchar('\n');
+    }
+}
+
+
+static void writeTrace(const char *file) {
+    FILE *f = fopen(file, "w");
+    const bool failed = !f || trace_write(f);
+    if ((f && fclose(f)) || failed)
+        fprintf(stderr, "Could not write the trace to \"%s\".\n", file);
+}
+
+
+int gameOfLifeHeadless(struct GOL_Pattern patinfo, struct GOL_Options options, uint64_t gens) {
+    // before the universe is created, so that its worker threads are traced from the start
+    trace_nameThread("main");
+    if (options.trace && trace_enable()) {
+        fprintf(stderr, "Could not allocate the trace buffers, not tracing.\n");
+        options.trace = NULL;
+    }
+    GOL_Universe *u = world_create(patinfo, options, false);
+    if (options.counters) {
+        prof_enable(true);
+        prof_enableCounters();
+    }
+
+    // the population is sampled before every step or jump, so jumps may hide a short-lived peak
+    uint64_t cellUpdates = 0, population = gol_population(u), peak = population;
+    // heap allocations while stepping, and the generation computed by the latest step that allocated
+    const uint64_t allocationsBefore = gol_allocations();
+    uint64_t allocations = allocationsBefore, allocatedAt = 0;
+    const double start = now();
+    while (gol_generation(u) < gens) {
+        const uint64_t advanced = gol_advance(u, gens - gol_generation(u));
+        if (gol_allocations() != allocations) {
+            allocations = gol_allocations();
+            allocatedAt = gol_generation(u);
+        }
+        cellUpdates += population * advanced;
+        population = gol_population(u);
+        peak = population > peak ? population : peak;
+    }
+    const double seconds = now() - start;
+    const uint64_t generation = gol_generation(u);
+
+    printf("#C Engine: %s\n", gol_engineName(u));
+    printf("#C Generations: %llu\n", (unsigned long long) generation);
+    printf("#C Seconds: %.6f\n", seconds);
+    printf("#C Generations/s: %.1f\n", seconds > 0 ? (double) generation / seconds : 0.);
+    printf("#C Cells/s: %.1f\n", seconds > 0 ? (double) cellUpdates / seconds : 0.);
+    printf("#C Peak population: %llu\n", (unsigned long long) peak);
+    printf("#C Final population: %llu\n", (unsigned long long) population);
+    if (allocations == allocationsBefore)
+        printf("#C Heap allocations: none while stepping\n");
+    else
+        printf("#C Heap allocations: %llu while stepping, the last one computing generation %llu\n",
+               (unsigned long long) (allocations - allocationsBefore), (unsigned long long) allocatedAt);
+    GOL_MemoryStats memory;
+    if (gol_memory(u, &memory))
+        printf("#C Arena: %llu allocations, %llu frees, %llu slabs, %llu KiB reserved, peak %llu KiB in use\n",
+               (unsigned long long) memory.allocations, (unsigned long long) memory.frees,
+               (unsigned long long) memory.slabs, (unsigned long long) memory.reserved / 1024,
+               (unsigned long long) memory.peakInUse / 1024);
+    if (prof_counting())
+        printCounters();
+    const bool failed = gol_writeRLE(u, stdout) || fflush(stdout);
+    if (options.trace)
+        writeTrace(options.trace);
+
+    gol_destroy(u);
+    if (failed)
+        fprintf(stderr, "Could not write the pattern.\n");
+    return failed;
+}
@@ -0,0 +1,38 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "heap.h"
+#include <stdlib.h>
+#include <stdatomic.h>
+
+static _Atomic uint64_t allocations;
+
+
+void *heap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return malloc(size);
+}
+
+
+void *heap_calloc(size_t n, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return calloc(n, size);
+}
+
+
+void *heap_realloc(void *p, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return realloc(p, size);
+}
+
+
+void *heap_alignedAlloc(size_t alignment, size_t size) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+
+uint64_t heap_allocations(void) {
+    return atomic_load_explicit(&allocations, memory_order_relaxed);
+}
@@ -0,0 +1,32 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_HEAP_H
+#define GAMEOFLIFE_HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Every heap allocation of the library goes through these wrappers of malloc(), calloc(),
+ * realloc() and aligned_alloc(), which count them, so that steps can be checked to allocate nothing once warmed up.
+ * Memory is released with free() as usual.
+ */
+
+void *heap_malloc(size_t size);
+
+void *heap_calloc(size_t n, size_t size);
+
+// counted even if the block is resized in place
+void *heap_realloc(void *p, size_t size);
+
+// alignment must be a power of two; size need not be a multiple of it
+void *heap_alignedAlloc(size_t alignment, size_t size);
+
+/**
+ * @return allocations made by any thread since the process started
+ */
+uint64_t heap_allocations(void);
+
+#endif //GAMEOFLIFE_HEAP_H
@@ -11,6 +11,7 @@
  */
 
 
+#ifndef GOL_HEADLESS_ONLY
 // resolution
 struct IntTuple {
     int w, h;
@@ -65,6 +66,55 @@ static unsigned parseUpdateRate(int argc, char **argv) {
     }
     return u;
 }
+#endif
+
+
+static unsigned parseThreads(int argc, char **argv) {
+    unsigned j = 1;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-j")) {
+            errno = 0;
+            j = (unsigned) strtoul(argv[i + 1], NULL, 10);
+            if (errno != 0 || j == 0)
+                j = 1;
+        }
+    }
+    return j;
+}
+
+
+#ifndef GOL_HEADLESS_ONLY
+static bool parseHeadless(int argc, char **argv) {
+    for (int i = 0; i < argc; ++i) {
+        if (!strcmp(argv[i], "--headless"))
+            return true;
+    }
+    return false;
+}
+#endif
+
+
+static bool parseCounters(int argc, char **argv) {
+    for (int i = 0; i < argc; ++i) {
+        if (!strcmp(argv[i], "-counters"))
+            return true;
+    }
+    return false;
+}
+
+
+static uint64_t parseGenerations(int argc, char **argv) {
+    uint64_t gens = 1000;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "--gens")) {
+            errno = 0;
+            gens = strtoull(argv[i + 1], NULL, 10);
+            if (errno != 0)
+                gens = 1000;
+        }
+    }
+    return gens;
+}
 
 
 static struct GOL_Pattern parsePatternToLoad(int argc, char **argv) {
@@ -123,6 +173,60 @@ static const char *parseRulestringToLoad(int argc, char **argv) {
 }
 
 
+static const char *parseEngine(int argc, char **argv) {
+    const char *engine = NULL;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-e"))
+            engine = argv[i + 1];
+    }
+    return engine;
+}
+
+
+static const char *parseTopology(int argc, char **argv) {
+    const char *topology = NULL;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-topology"))
+            topology = argv[i + 1];
+    }
+    return topology;
+}
+
+
+static const char *parseProfile(int argc, char **argv) {
+    const char *profile = NULL;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-profile"))
+            profile = argv[i + 1];
+    }
+    return profile;
+}
+
+
+static const char *parseTrace(int argc, char **argv) {
+    const char *trace = NULL;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-trace"))
+            trace = argv[i + 1];
+    }
+    return trace;
+}
+
+
+static unsigned parseMemoryBudget(int argc, char **argv) {
+    unsigned m = 0;
+    for (int i = 0; i < argc - 1; ++i) {
+        if (!strcmp(argv[i], "-m")) {
+            errno = 0;
+            m = (unsigned) strtoul(argv[i + 1], NULL, 10);
+            if (errno != 0)
+                m = 0;
+        }
+    }
+    return m;
+}
+
+
 static bool showHelp(int argc, char **argv) {
     for (int i = 0; i < argc; ++i) {
         if (!strcmp(argv[i], "-h"))
@@ -141,10 +245,25 @@ help:
         "    -w               - Set initial window width.\n"
         "    -h               - Set initial window height.\n"
         "    -t               - Set initial game tick rate.\n"
+        "    -j               - Set number of threads stepping the world (tile, dense and sortcount engines).\n"
         "    -fp              - Load plaintext pattern file.\n"
         "    -fr              - Load RLE pattern file.\n"
         "    -f               - Load pattern file. Type determined by file extension.\n"
-        "    -r               - Override rulestring.\n"
+        "    -r               - Override rulestring, e.g. B3/S23, 23/3 or isotropic B2-a/S12.\n"
+        "                       Generations rules append the number of states, e.g. B2/S/C3 (tile engine).\n"
+        "    -e               - Select simulation engine: sorted (default), hash, tile, hashlife, dense, sweep,\n"
+        "                       sortcount.\n"
+        "    -m               - Set memory budget of the engine's caches in MiB (hashlife).\n"
+        "    -topology        - Bound the universe to a plane, torus or Klein bottle, e.g. P:100x80, T:640x480\n"
+        "                       or K:256x256 (dense engine). Cells 0 <= x < width, 0 <= y < height.\n"
+        "    -profile         - Stream the profiler's phase timings to a CSV file once per frame.\n"
+        "    -counters        - Add hardware counters (perf events) to the profiler: IPC as well as cache and branch\n"
+        "                       misses per cell update, shown in the HUD and the headless summary. Linux only.\n"
+        "    -trace           - Record a timeline of frames and generations and write it as Chrome trace JSON\n"
+        "                       (chrome://tracing, Perfetto) to a file on exit and when pressing F4.\n"
+        "    --headless       - Run without a window and write the final pattern as RLE plus timings to stdout.\n"
+        "                       Implied by golheadless, the build without SDL.\n"
+        "    --gens           - Set number of generations to run in headless mode (default 1000).\n"
         "Any option may override previous options. All options and their parameters are space-separated.\n"
         "\n"
         "\n"
@@ -162,8 +281,15 @@ help:
         "    BACKSPACE                - Clear the world.\n"
         "    Q                        - Decrease tick rate by 1; 10 when holding SHIFT, 100 when holding CTRL.\n"
         "    E                        - Increase tick rate by 1; 10 when holding SHIFT, 100 when holding CTRL.\n"
+        "                               Engines able to jump (hashlife) advance by the largest power of two due at once.\n"
+        "    H                        - Toggle hyperspeed: 2^k generations per frame, k adapting so that a frame\n"
+        "                               stays within its time budget. Generations per second are shown in the title.\n"
+        "    F3                       - Toggle the profiler HUD: rolling statistics and histograms of the time spent in\n"
+        "                               every phase of a generation (sorted engine) and of a frame.\n"
+        "    F4                       - Write the trace, if tracing.\n"
         "    B                        - Store a snapshot of the game state.\n"
         "    R                        - Restore the most recently stored game state snapshot.\n"
+        "    TAB                      - Type a new rulestring; ENTER applies it, ESCAPE cancels.\n"
         "    Number keys              - Switch between available cell textures.\n"
         "    ESCAPE                   - Exit game."
     );
@@ -174,9 +300,24 @@ help:
 int main(int argc, char **argv) {
     if (showHelp(argc - 1, argv + 1))
         return 0;
-    struct IntTuple res = parseResolution(argc - 1, argv + 1);
-    unsigned updates = parseUpdateRate(argc - 1, argv + 1);
     struct GOL_Pattern patinfo = parsePatternToLoad(argc - 1, argv + 1);
     patinfo.rules = parseRulestringToLoad(argc - 1, argv + 1);
-    gameOfLife(res.w, res.h, updates, patinfo);
+    struct GOL_Options options = {0};
+    options.engine = parseEngine(argc - 1, argv + 1);
+    options.memoryBudget = parseMemoryBudget(argc - 1, argv + 1);
+    options.threads = parseThreads(argc - 1, argv + 1);
+    options.topology = parseTopology(argc - 1, argv + 1);
+    options.profile = parseProfile(argc - 1, argv + 1);
+    options.counters = parseCounters(argc - 1, argv + 1);
+    options.trace = parseTrace(argc - 1, argv + 1);
+#ifdef GOL_HEADLESS_ONLY
+    // built without the SDL front end, see golheadless in CMakeLists.txt
+    return gameOfLifeHeadless(patinfo, options, parseGenerations(argc - 1, argv + 1));
+#else
+    if (parseHeadless(argc - 1, argv + 1))
+        return gameOfLifeHeadless(patinfo, options, parseGenerations(argc - 1, argv + 1));
+    struct IntTuple res = parseResolution(argc - 1, argv + 1);
+    unsigned updates = parseUpdateRate(argc - 1, argv + 1);
+    gameOfLife(res.w, res.h, updates, patinfo, options);
+#endif
 }
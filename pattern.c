@@ -0,0 +1,304 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "pattern.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#define RLE_LINE_LENGTH 70
+
+// a cell keyed by row first, so that sorting orders cells the way RLE lists them
+typedef struct RowCell {
+    Cell key;       // cell_make(y, x)
+    uint8_t state;
+} RowCell;
+
+typedef struct RowCells {
+    RowCell *cells;
+    uint64_t len, cap;
+} RowCells;
+
+// pending run of an RLE writer; runs of the same tag are merged before they are written
+typedef struct RLEWriter {
+    FILE *f;
+    int lineLength;
+    uint64_t count;
+    char tag[3];
+} RLEWriter;
+
+
+cellset *pattern_layer(cellset **layers, unsigned state) {
+    if (!layers[state] && !(layers[state] = cs_new())) {
+        fprintf(stderr, "Could not allocate memory for the cells of state %u.\n", state);
+        abort();
+    }
+    return layers[state];
+}
+
+
+void pattern_destroyLayers(cellset **layers) {
+    for (unsigned state = 0; state < RULES_MAX_STATES; ++state)
+        cs_destroy(layers[state]);
+}
+
+
+void pattern_addToWorld(const struct GOL_Engine *engine, void *world, cellset **layers) {
+    if (layers[1])
+        engine->load(world, layers[1]);
+    for (unsigned state = 2; state < RULES_MAX_STATES && engine->setState; ++state) {
+        for (uint64_t i = 0; layers[state] && i < layers[state]->len; ++i)
+            engine->setState(world, layers[state]->cells[i], (uint8_t) state);
+    }
+}
+
+
+void pattern_loadPlaintext(const char *s, cellset **layers) {
+    while (*s && *s == '!') {
+        while (*s && *s != '\n')
+            ++s;
+        s += !!*s;
+    }
+
+    for (int64_t x = 0, y = 0; *s; ++s, ++x) {
+        if (*s == '.')
+            continue;
+        if (*s == '\r')
+            continue;
+        if (*s == '\n') {
+            x = -1;
+            ++y;
+            continue;
+        }
+        if (*s == 'O')
+            cs_push(pattern_layer(layers, 1), cell_make((int32_t) x, (int32_t) y));
+    }
+}
+
+
+/*
+ * Besides b and o for dead and live cells, multi-state RLE encodes state 0 as '.' and the
+ * states 1 to 24 as 'A' to 'X'; a prefix 'p' to 'y' adds 24 times its distance from 'o'.
+ * A comment line "#CXRLE Pos=x,y" places the top left corner of the pattern at (x, y).
+ */
+char *pattern_loadRLE(const char *s, cellset **layers) {
+    long long x0 = 0, y0 = 0;
+    while (*s && *s == '#') {
+        const char *line = s;
+        while (*s && *s != '\n')
+            ++s;
+        const char *pos = strstr(line, "Pos=");
+        if (!strncmp(line, "#CXRLE", 6) && pos && pos < s && sscanf(pos, "Pos=%lld,%lld", &x0, &y0) != 2)
+            x0 = y0 = 0;
+        s += !!*s;
+    }
+
+    uint64_t w = 0, h = 0;
+    for (uint64_t *fill = &w; *s && *s != '\n'; ++s) {
+        if (!isdigit(*s))
+            continue;
+
+        errno = 0;
+        char *tmp;
+        *fill = strtoull(s, &tmp, 10);
+        if (errno) return NULL;
+        s = tmp - 1;
+        if (fill == &h) break;
+        fill = &h;
+    }
+
+    char *rulestring = NULL;
+    while (*s != '\n') {
+        if (*s == '=') {
+            do ++s; while (*s != '\n' && isspace(*s));
+            if (*s == '\n') break;
+            const char *start = s;
+            const char *end = strchr(s, '\n');
+            rulestring = heap_malloc(end - start + 1);
+            memcpy(rulestring, start, end - start);
+            rulestring[end - start] = '\0';
+        }
+        ++s;
+    }
+
+    enum States {COUNT, TAG};
+    enum States state = COUNT;
+    unsigned prefix = 0;
+    for (int64_t x = x0, y = y0, count = 0; *s && *s != '!'; ++s) {
+        if (isspace(*s))
+            continue;
+
+        if (state == COUNT) {
+            if (isdigit(*s)) {
+                int digit = *s - '0';
+                count = count * 10 + digit;
+            } else {
+                count += !count;
+                state = TAG;
+                --s;
+            }
+        }
+
+        else /*if (state == TAG)*/ {
+            if (*s >= 'p' && *s <= 'y') {
+                prefix = (*s - 'o') * 24;
+                continue;   // the count applies to the state that follows
+            }
+
+            unsigned cellState = 0;
+            if (*s == 'o')
+                cellState = 1;
+            else if (*s >= 'A' && *s <= 'X')
+                cellState = prefix + (*s - 'A') + 1;
+
+            if (*s == 'b' || *s == '.') {
+                x += count;
+            } else if (*s == '$') {
+                x = x0;
+                y += count;
+            } else if (cellState && cellState < RULES_MAX_STATES) {
+                while (count--)
+                    cs_push(pattern_layer(layers, cellState), cell_make((int32_t) x++, (int32_t) y));
+            }
+
+            prefix = 0;
+            count = 0;
+            state = COUNT;
+        }
+    }
+
+    return rulestring;
+}
+
+
+static void pushRowCell(RowCells *cells, Cell c, uint8_t state) {
+    if (cells->len == cells->cap) {
+        const uint64_t cap = cells->cap ? cells->cap * 2 : 1024;
+        RowCell *grown = heap_realloc(cells->cells, cap * sizeof *grown);
+        if (!grown) {
+            fprintf(stderr, "Could not allocate memory for writing the pattern.\n");
+            abort();
+        }
+        cells->cells = grown;
+        cells->cap = cap;
+    }
+    cells->cells[cells->len++] = (RowCell) {cell_make(cell_y(c), cell_x(c)), state};
+}
+
+
+static void collectLive(Cell c, void *cells) {
+    pushRowCell(cells, c, 1);
+}
+
+
+static void collectState(Cell c, uint8_t state, void *cells) {
+    pushRowCell(cells, c, state);
+}
+
+
+static int compareRowCells(const void *a, const void *b) {
+    const Cell x = ((const RowCell *) a)->key, y = ((const RowCell *) b)->key;
+    return (x > y) - (x < y);
+}
+
+
+static void flushRun(RLEWriter *wr) {
+    if (!wr->count)
+        return;
+
+    char run[32];
+    if (wr->count > 1)
+        snprintf(run, sizeof run, "%llu%s", (unsigned long long) wr->count, wr->tag);
+    else
+        snprintf(run, sizeof run, "%s", wr->tag);
+
+    const int length = (int) strlen(run);
+    if (wr->lineLength + length > RLE_LINE_LENGTH) {
+        fputc('\n', wr->f);
+        wr->lineLength = 0;
+    }
+    fputs(run, wr->f);
+    wr->lineLength += length;
+    wr->count = 0;
+}
+
+
+static void writeRun(RLEWriter *wr, uint64_t count, const char *tag) {
+    if (strcmp(wr->tag, tag)) {
+        flushRun(wr);
+        strcpy(wr->tag, tag);
+    }
+    wr->count += count;
+}
+
+
+// tag of a cell state: b and o for two-state rules, '.', 'A' to 'X' and prefixed letters otherwise
+static void stateTag(char *tag, unsigned state, bool multiState) {
+    if (!multiState) {
+        strcpy(tag, state ? "o" : "b");
+    } else if (!state) {
+        strcpy(tag, ".");
+    } else {
+        const unsigned prefix = (state - 1) / 24;
+        tag[0] = prefix ? (char) ('o' + prefix) : (char) ('A' + (state - 1) % 24);
+        tag[1] = prefix ? (char) ('A' + (state - 1) % 24) : '\0';
+        tag[2] = '\0';
+    }
+}
+
+
+bool pattern_writeRLE(FILE *f, const struct GOL_Engine *engine, void *world, const Rules *rules, const char *rulestring) {
+    const bool multiState = rules->states > 2 && engine->forEachStateInRect;
+    const CellRect everything = {INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX};
+    RowCells cells = {0};
+    if (multiState)
+        engine->forEachStateInRect(world, &everything, collectState, &cells);
+    else
+        engine->forEachInRect(world, &everything, collectLive, &cells);
+    qsort(cells.cells, cells.len, sizeof *cells.cells, compareRowCells);
+
+    // rows are sorted, columns have to be searched
+    int64_t x0 = INT32_MAX, x1 = INT32_MIN, y0 = 0, y1 = -1;
+    for (uint64_t i = 0; i < cells.len; ++i) {
+        const int64_t x = cell_y(cells.cells[i].key);
+        x0 = x < x0 ? x : x0;
+        x1 = x > x1 ? x : x1;
+    }
+    if (cells.len) {
+        y0 = cell_x(cells.cells[0].key);
+        y1 = cell_x(cells.cells[cells.len - 1].key);
+    } else {
+        x0 = 0;
+        x1 = -1;
+    }
+
+    fprintf(f, "#CXRLE Pos=%lld,%lld\n", (long long) x0, (long long) y0);
+    fprintf(f, "x = %lld, y = %lld, rule = %s\n", (long long) (x1 - x0 + 1), (long long) (y1 - y0 + 1), rulestring);
+
+    RLEWriter wr = {f, 0, 0, ""};
+    char tag[3];
+    int64_t x = x0, y = y0;
+    for (uint64_t i = 0; i < cells.len; ++i) {
+        const int64_t cx = cell_y(cells.cells[i].key), cy = cell_x(cells.cells[i].key);
+        if (cy > y) {
+            writeRun(&wr, cy - y, "$");
+            x = x0;
+            y = cy;
+        }
+        if (cx > x) {
+            stateTag(tag, 0, multiState);
+            writeRun(&wr, cx - x, tag);
+        }
+        stateTag(tag, cells.cells[i].state, multiState);
+        writeRun(&wr, 1, tag);
+        x = cx + 1;
+    }
+    flushRun(&wr);
+    fputs("!\n", f);
+
+    free(cells.cells);
+    return ferror(f);
+}
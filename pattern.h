@@ -0,0 +1,66 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_PATTERN_H
+#define GAMEOFLIFE_PATTERN_H
+
+#include "engine.h"
+#include <stdio.h>
+
+/*
+ * Patterns are read into layers: an array of RULES_MAX_STATES cellsets indexed by cell state,
+ * where layer 1 holds the live cells. Layers without cells are NULL, so a zero-initialised
+ * array is an empty pattern.
+ */
+
+/**
+ * Layer of the given state, created on first use. Aborts if out of memory.
+ * @param layers layers
+ * @param state cell state below RULES_MAX_STATES
+ * @return the layer
+ */
+cellset *pattern_layer(cellset **layers, unsigned state);
+
+/**
+ * Destroy every layer; the array itself is not freed.
+ * @param layers layers
+ */
+void pattern_destroyLayers(cellset **layers);
+
+/**
+ * Add the cells of every layer to a world. States the engine cannot represent are skipped.
+ * @param engine engine of the world
+ * @param world world
+ * @param layers layers
+ */
+void pattern_addToWorld(const struct GOL_Engine *engine, void *world, cellset **layers);
+
+/**
+ * Read a plaintext pattern: lines starting with ! are comments, O is a live cell.
+ * @param s pattern file contents
+ * @param layers receives the cells
+ */
+void pattern_loadPlaintext(const char *s, cellset **layers);
+
+/**
+ * Read an RLE pattern, including multi-state RLE for Generations rules.
+ * @param s pattern file contents
+ * @param layers receives the cells
+ * @return rulestring of the pattern, which must be freed, or NULL if it has none
+ */
+char *pattern_loadRLE(const char *s, cellset **layers);
+
+/**
+ * Write the cells of a world as an RLE pattern. The position of the pattern is kept in
+ * a #CXRLE comment line, which other readers ignore.
+ * @param f output file
+ * @param engine engine of the world
+ * @param world world
+ * @param rules rules of the world; Generations rules write multi-state RLE
+ * @param rulestring rulestring for the header line
+ * @return true if writing failed
+ */
+bool pattern_writeRLE(FILE *f, const struct GOL_Engine *engine, void *world, const Rules *rules, const char *rulestring);
+
+#endif //GAMEOFLIFE_PATTERN_H
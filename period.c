@@ -0,0 +1,63 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "period.h"
+
+#define SLOT(gen) ((gen) % PERIOD_HISTORY)
+
+
+void period_reset(PeriodTracker *t) {
+    t->observed = 0;
+    t->period = 0;
+    t->stableSince = 0;
+}
+
+
+static bool sameGeneration(const PeriodTracker *t, uint64_t a, uint64_t b) {
+    return t->hashes[SLOT(a)] == t->hashes[SLOT(b)];
+}
+
+
+// return true if the last 2p generations are two identical cycles of length p
+static bool repeats(const PeriodTracker *t, uint64_t p) {
+    for (uint64_t i = 0; i < p; ++i) {
+        if (!sameGeneration(t, t->generation - i, t->generation - i - p))
+            return false;
+    }
+    return true;
+}
+
+
+bool period_observe(PeriodTracker *t, uint64_t generation, uint64_t hash) {
+    if (t->period)
+        return false;
+    if (t->observed && generation != t->generation + 1)
+        t->observed = 0;
+
+    t->generation = generation;
+    t->hashes[SLOT(generation)] = hash;
+    if (t->observed < PERIOD_HISTORY)
+        ++t->observed;
+
+    for (uint64_t p = 1; 2 * p <= t->observed; ++p) {
+        if (!repeats(t, p))
+            continue;
+
+        // walk back to the first generation that already belongs to the cycle
+        uint64_t since = generation - 2 * p + 1;
+        while (since > generation - t->observed + 1 && sameGeneration(t, since - 1, since - 1 + p))
+            --since;
+
+        t->period = p;
+        t->stableSince = since;
+        return true;
+    }
+
+    return false;
+}
+
+
+uint64_t period_reduce(const PeriodTracker *t, uint64_t gens) {
+    return t->period ? gens % t->period : gens;
+}
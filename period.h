@@ -0,0 +1,51 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_PERIOD_H
+#define GAMEOFLIFE_PERIOD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PERIOD_HISTORY 128
+
+/*
+ * Detects when a world has become periodic from the world hashes of consecutive generations.
+ * A period p is only accepted once the last 2p generations form two identical cycles,
+ * so periods up to PERIOD_HISTORY / 2 are found. Equal hashes are taken as equal worlds.
+ * Worlds that emit gliders or other spaceships never repeat as a whole and are never periodic.
+ */
+typedef struct PeriodTracker {
+    uint64_t hashes[PERIOD_HISTORY];    // indexed by generation modulo PERIOD_HISTORY
+    uint64_t generation;    // generation of the latest observation
+    uint64_t observed;      // consecutive generations recorded, at most PERIOD_HISTORY
+    uint64_t period;        // 0 while the world is not known to be periodic
+    uint64_t stableSince;   // first generation of the periodic state
+} PeriodTracker;
+
+/**
+ * Forget all observations, e.g. after the world was edited.
+ * @param t tracker
+ */
+void period_reset(PeriodTracker *t);
+
+/**
+ * Record a generation. Observations of non-consecutive generations restart the tracking.
+ * Once a period is found, further observations are ignored until the next reset.
+ * @param t tracker
+ * @param generation generation number
+ * @param hash world hash of that generation
+ * @return true if this observation revealed the period
+ */
+bool period_observe(PeriodTracker *t, uint64_t generation, uint64_t hash);
+
+/**
+ * Number of generations that actually have to be computed to advance by gens generations.
+ * @param t tracker
+ * @param gens generations to advance by
+ * @return gens modulo the period if the world is periodic, gens otherwise
+ */
+uint64_t period_reduce(const PeriodTracker *t, uint64_t gens);
+
+#endif //GAMEOFLIFE_PERIOD_H
@@ -0,0 +1,284 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#define _GNU_SOURCE
+#include "profile.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+typedef struct Sample {
+    _Atomic uint64_t ns;
+    _Atomic uint64_t units;
+    _Atomic uint64_t events[PROF_EVENTS];
+    _Atomic bool counted;
+} Sample;
+
+typedef struct PhaseRecord {
+    Sample samples[PROF_SAMPLES];       // indexed by count modulo PROF_SAMPLES
+    _Atomic uint64_t count;
+    _Atomic uint64_t totalNs;
+    Sample counted;                     // sums of the samples counted, with the number of them as ns
+} PhaseRecord;
+
+// hardware counters of a thread, read as one group through the leader
+typedef struct Counters {
+    bool tried;                 // whether they have been opened
+    int leader;                 // -1 if none could be opened
+    int index[PROF_EVENTS];     // position of every event in a group read, -1 if it could not be opened
+} Counters;
+
+static PhaseRecord records[PROF_PHASES];
+static _Atomic bool enabled;
+static _Atomic bool countersEnabled;
+static _Atomic unsigned availableEvents;    // bit per event opened by any thread
+static _Atomic bool failureReported;
+static _Thread_local Counters counters = {.leader = -1};
+
+static const char *const names[PROF_PHASES] = {
+        "prepare", "unique", "worthy", "spawning", "extend", "advance", "publish", "inputs", "draw"
+};
+
+static const char *const eventNames[PROF_EVENTS] = {
+        "cycles", "instructions", "l1-misses", "llc-misses", "branch-misses"
+};
+
+
+void prof_enable(bool enable) {
+    atomic_store_explicit(&enabled, enable, memory_order_relaxed);
+}
+
+
+bool prof_enabled(void) {
+    return atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+
+static void reportFailure(const char *reason) {
+    if (!atomic_exchange(&failureReported, true))
+        fprintf(stderr, "Hardware counters are not available (%s), profiling without them.\n", reason);
+}
+
+
+#ifdef __linux__
+static int openEvent(ProfileEvent event, int leader) {
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } configs[PROF_EVENTS] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+    };
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = configs[event].type;
+    attr.config = configs[event].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = leader < 0;     // the group is started once it is complete
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+
+// open the counters of the calling thread unless that has been tried before; return true if it has none
+static bool openCounters(void) {
+    Counters *c = &counters;
+    if (c->tried)
+        return c->leader < 0;
+    c->tried = true;
+
+    // events the CPU or kernel does not support are left out, the first one opened leads the group
+    int opened = 0, error = 0;
+    unsigned mask = 0;
+    for (ProfileEvent e = 0; e < PROF_EVENTS; ++e) {
+        const int fd = openEvent(e, c->leader);
+        c->index[e] = fd < 0 ? -1 : opened++;
+        if (fd < 0) {
+            error = error ? error : errno;
+            continue;
+        }
+        if (c->leader < 0)
+            c->leader = fd;
+        mask |= 1u << e;
+    }
+    if (c->leader < 0) {
+        reportFailure(error == EACCES || error == EPERM ? "not permitted, see /proc/sys/kernel/perf_event_paranoid" : strerror(error));
+        return true;
+    }
+
+    ioctl(c->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(c->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    atomic_fetch_or(&availableEvents, mask);
+    return false;
+}
+
+
+// return true if the counters could not be read
+static bool readCounters(uint64_t *events) {
+    uint64_t values[1 + PROF_EVENTS];   // number of events, then their values
+    if (read(counters.leader, values, sizeof values) < (ssize_t) sizeof *values)
+        return true;
+    for (ProfileEvent e = 0; e < PROF_EVENTS; ++e)
+        events[e] = counters.index[e] >= 0 ? values[1 + counters.index[e]] : 0;
+    return false;
+}
+#else
+static bool openCounters(void) {
+    reportFailure("only supported on Linux");
+    return true;
+}
+
+
+static bool readCounters(uint64_t *events) {
+    (void) events;
+    return true;
+}
+#endif
+
+
+bool prof_enableCounters(void) {
+    atomic_store(&countersEnabled, true);
+    if (openCounters()) {
+        atomic_store(&countersEnabled, false);
+        return true;
+    }
+    return false;
+}
+
+
+bool prof_counting(void) {
+    return prof_enabled() && atomic_load_explicit(&countersEnabled, memory_order_relaxed) && !openCounters();
+}
+
+
+void prof_mark(ProfileMark *m) {
+    m->counted = prof_counting() && !readCounters(m->events);
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    m->ns = (uint64_t) t.tv_sec * 1000000000u + (uint64_t) t.tv_nsec;
+}
+
+
+void prof_accumulate(ProfileMark *total, const ProfileMark *from, const ProfileMark *to) {
+    total->ns += to->ns - from->ns;
+    total->counted = total->counted && from->counted && to->counted;
+    for (ProfileEvent e = 0; e < PROF_EVENTS; ++e)
+        total->events[e] += to->events[e] - from->events[e];
+}
+
+
+void prof_record(ProfilePhase phase, const ProfileMark *from, const ProfileMark *to, uint64_t units) {
+    ProfileMark total = {.counted = true};
+    prof_accumulate(&total, from, to);
+    prof_recordTotal(phase, &total, units);
+}
+
+
+void prof_recordTotal(ProfilePhase phase, const ProfileMark *total, uint64_t units) {
+    if (!prof_enabled())
+        return;
+
+    // the only writer of the phase, so plain loads and stores suffice; release publishes the sample
+    PhaseRecord *r = &records[phase];
+    const uint64_t count = atomic_load_explicit(&r->count, memory_order_relaxed);
+    Sample *s = &r->samples[count % PROF_SAMPLES];
+    atomic_store_explicit(&s->ns, total->ns, memory_order_relaxed);
+    atomic_store_explicit(&s->units, units, memory_order_relaxed);
+    atomic_store_explicit(&s->counted, total->counted, memory_order_relaxed);
+    for (ProfileEvent e = 0; e < PROF_EVENTS && total->counted; ++e)
+        atomic_store_explicit(&s->events[e], total->events[e], memory_order_relaxed);
+    if (total->counted) {
+        Sample *sum = &r->counted;
+        atomic_store_explicit(&sum->ns, atomic_load_explicit(&sum->ns, memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_store_explicit(&sum->units, atomic_load_explicit(&sum->units, memory_order_relaxed) + units, memory_order_relaxed);
+        for (ProfileEvent e = 0; e < PROF_EVENTS; ++e) {
+            const uint64_t events = atomic_load_explicit(&sum->events[e], memory_order_relaxed) + total->events[e];
+            atomic_store_explicit(&sum->events[e], events, memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&r->totalNs, atomic_load_explicit(&r->totalNs, memory_order_relaxed) + total->ns, memory_order_relaxed);
+    atomic_store_explicit(&r->count, count + 1, memory_order_release);
+}
+
+
+static int compareDurations(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+
+void prof_stats(ProfilePhase phase, ProfileStats *stats) {
+    PhaseRecord *r = &records[phase];
+    *stats = (ProfileStats) {0};
+    stats->count = atomic_load_explicit(&r->count, memory_order_acquire);
+    stats->totalNs = atomic_load_explicit(&r->totalNs, memory_order_relaxed);
+    stats->samples = stats->count < PROF_SAMPLES ? stats->count : PROF_SAMPLES;
+    const unsigned available = atomic_load_explicit(&availableEvents, memory_order_relaxed);
+    stats->all.samples = atomic_load_explicit(&r->counted.ns, memory_order_relaxed);
+    stats->all.units = atomic_load_explicit(&r->counted.units, memory_order_relaxed);
+    for (ProfileEvent e = 0; e < PROF_EVENTS; ++e) {
+        stats->available[e] = available >> e & 1;
+        stats->all.events[e] = atomic_load_explicit(&r->counted.events[e], memory_order_relaxed);
+    }
+    if (!stats->samples)
+        return;
+
+    // samples overwritten while they are copied only skew the window by a few recent ones
+    uint64_t window[PROF_SAMPLES], sum = 0;
+    for (uint64_t i = 0; i < stats->samples; ++i) {
+        const Sample *s = &r->samples[i];
+        window[i] = atomic_load_explicit(&s->ns, memory_order_relaxed);
+        sum += window[i];
+        const int bucket = window[i] ? 63 - __builtin_clzll(window[i]) : 0;
+        ++stats->histogram[bucket < PROF_BUCKETS ? bucket : PROF_BUCKETS - 1];
+
+        if (!atomic_load_explicit(&s->counted, memory_order_relaxed))
+            continue;
+        ++stats->window.samples;
+        stats->window.units += atomic_load_explicit(&s->units, memory_order_relaxed);
+        for (ProfileEvent e = 0; e < PROF_EVENTS; ++e)
+            stats->window.events[e] += atomic_load_explicit(&s->events[e], memory_order_relaxed);
+    }
+    qsort(window, stats->samples, sizeof *window, compareDurations);
+
+    stats->meanNs = sum / stats->samples;
+    stats->p50Ns = window[stats->samples / 2];
+    stats->p99Ns = window[(stats->samples * 99) / 100];
+    stats->maxNs = window[stats->samples - 1];
+}
+
+
+double prof_ipc(const ProfileCounts *counts) {
+    return counts->events[PROF_CYCLES] ? (double) counts->events[PROF_INSTRUCTIONS] / (double) counts->events[PROF_CYCLES] : -1;
+}
+
+
+double prof_perUnit(const ProfileCounts *counts, ProfileEvent event) {
+    return counts->units ? (double) counts->events[event] / (double) counts->units : -1;
+}
+
+
+const char *prof_name(ProfilePhase phase) {
+    return names[phase];
+}
+
+
+const char *prof_eventName(ProfileEvent event) {
+    return eventNames[event];
+}
@@ -0,0 +1,157 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_PROFILE_H
+#define GAMEOFLIFE_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PROF_SAMPLES 256    // samples per phase in the rolling window
+#define PROF_BUCKETS 40     // histogram buckets; bucket i holds durations in [2^i, 2^(i+1)) ns
+
+/*
+ * Phase timers. Each phase keeps its latest PROF_SAMPLES samples in a ring, from which rolling
+ * statistics and histograms are computed on demand. Recording is lock-free and does nothing while
+ * profiling is disabled; every phase must only be recorded by one thread at a time, while
+ * statistics may be read from any thread.
+ * A sample spans two marks. Once hardware counters are enabled, marks also read the performance
+ * counters of the calling thread through perf_event_open(), so work done by the threads of a
+ * thread pool on behalf of a phase is not counted.
+ */
+typedef enum ProfilePhase {
+    PROF_PREPARE,       // sorted engine: merging placed cells into the live cells, rebuilding the filter
+    PROF_UNIQUE,        // sorted engine: removing duplicate potential cells
+    PROF_WORTHY,        // sorted engine: finding survivors and potential births
+    PROF_SPAWNING,      // sorted engine: filtering births from the potential cells
+    PROF_EXTEND,        // sorted engine: merging survivors and births
+    PROF_ADVANCE,       // one call of gol_advance(), any engine
+    PROF_PUBLISH,       // gathering the cells of a frame
+    PROF_INPUTS,        // processing the inputs of a frame
+    PROF_DRAW,          // drawing a frame, without waiting for the display
+    PROF_PHASES
+} ProfilePhase;
+
+typedef enum ProfileEvent {
+    PROF_CYCLES,
+    PROF_INSTRUCTIONS,
+    PROF_L1_MISSES,     // L1 data cache read misses
+    PROF_LLC_MISSES,    // last level cache read misses
+    PROF_BRANCH_MISSES,
+    PROF_EVENTS
+} ProfileEvent;
+
+// a point in time and, if counted, the hardware events of the calling thread up to it
+typedef struct ProfileMark {
+    uint64_t ns;
+    uint64_t events[PROF_EVENTS];
+    bool counted;
+} ProfileMark;
+
+// hardware events of the samples that were counted
+typedef struct ProfileCounts {
+    uint64_t samples;
+    uint64_t units;     // cell updates, or cells drawn
+    uint64_t events[PROF_EVENTS];
+} ProfileCounts;
+
+typedef struct ProfileStats {
+    uint64_t count;     // durations recorded in total
+    uint64_t totalNs;   // sum of all durations recorded
+    // the following cover the rolling window only
+    uint64_t samples;
+    uint64_t meanNs, p50Ns, p99Ns, maxNs;
+    uint32_t histogram[PROF_BUCKETS];
+    ProfileCounts window;           // events of the rolling window
+    ProfileCounts all;              // events of every sample recorded
+    bool available[PROF_EVENTS];    // whether the event could be counted by any thread
+} ProfileStats;
+
+/**
+ * Enable or disable recording. Samples recorded before are kept.
+ * @param enabled whether durations are recorded
+ */
+void prof_enable(bool enabled);
+
+/**
+ * @return whether durations are recorded
+ */
+bool prof_enabled(void);
+
+/**
+ * Enable hardware counters for the marks of every thread, which open their counters on first use.
+ * Failures are reported to stderr; profiling then goes on without counters.
+ * @return true if the counters cannot be opened for the calling thread
+ */
+bool prof_enableCounters(void);
+
+/**
+ * @return whether profiling and hardware counters are enabled and the counters could be opened for the calling thread
+ */
+bool prof_counting(void);
+
+/**
+ * Take a mark: the monotonic time, which is read even while profiling is disabled, and the
+ * hardware events of the calling thread if counters are enabled.
+ * @param m receives the mark
+ */
+void prof_mark(ProfileMark *m);
+
+/**
+ * Add the span between two marks of the same thread to a total, e.g. to record phases interrupted by others.
+ * @param total zero-initialised total; counted as long as every span added is
+ * @param from start of the span
+ * @param to end of the span
+ */
+void prof_accumulate(ProfileMark *total, const ProfileMark *from, const ProfileMark *to);
+
+/**
+ * Record the span between two marks of the same thread if profiling is enabled.
+ * @param phase phase
+ * @param from start of the span
+ * @param to end of the span
+ * @param units cell updates done in the span, or cells drawn; 0 if unknown
+ */
+void prof_record(ProfilePhase phase, const ProfileMark *from, const ProfileMark *to, uint64_t units);
+
+/**
+ * Record a total built by prof_accumulate() if profiling is enabled.
+ * @param phase phase
+ * @param total duration and events
+ * @param units cell updates done; 0 if unknown
+ */
+void prof_recordTotal(ProfilePhase phase, const ProfileMark *total, uint64_t units);
+
+/**
+ * @param phase phase
+ * @param stats receives the statistics of the phase
+ */
+void prof_stats(ProfilePhase phase, ProfileStats *stats);
+
+/**
+ * @param counts hardware events
+ * @return instructions per cycle, negative if unknown
+ */
+double prof_ipc(const ProfileCounts *counts);
+
+/**
+ * @param counts hardware events
+ * @param event event
+ * @return events per cell update, negative if unknown
+ */
+double prof_perUnit(const ProfileCounts *counts, ProfileEvent event);
+
+/**
+ * @param phase phase
+ * @return short lower case name of the phase
+ */
+const char *prof_name(ProfilePhase phase);
+
+/**
+ * @param event event
+ * @return short lower case name of the event
+ */
+const char *prof_eventName(ProfileEvent event);
+
+#endif //GAMEOFLIFE_PROFILE_H
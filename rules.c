@@ -0,0 +1,246 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "rules.h"
+#include <ctype.h>
+#include <string.h>
+
+/*
+ * Hensel notation names the configurations of n neighbours that are equal up to rotation
+ * and reflection by letters. The neighbours are numbered clockwise starting north; a
+ * configuration is a byte with bit i set if neighbour i is alive.
+ */
+enum {N = 1, NE = 2, E = 4, SE = 8, S = 16, SW = 32, W = 64, NW = 128};
+
+static const int ringDX[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const int ringDY[8] = {-1, -1, 0, 1, 1, 1, 0, -1};     // y grows downwards
+
+#define HENSEL_LETTERS "ceaiknjqrytwz"
+
+// one representative for every letter of one to four neighbours;
+// five to seven neighbours take the letter of the complementary configuration
+static const struct {
+    uint8_t count;
+    char letter;
+    uint8_t ring;
+} hensel[] = {
+        {1, 'c', NE},
+        {1, 'e', N},
+
+        {2, 'c', NE | SE},
+        {2, 'e', N | E},
+        {2, 'k', N | SE},
+        {2, 'a', N | NE},
+        {2, 'i', N | S},
+        {2, 'n', NE | SW},
+
+        {3, 'c', NE | SE | SW},
+        {3, 'e', N | E | S},
+        {3, 'k', N | E | SW},
+        {3, 'a', N | NE | E},
+        {3, 'i', N | NE | NW},
+        {3, 'n', N | NE | SE},
+        {3, 'y', N | SE | SW},
+        {3, 'q', N | NE | SW},
+        {3, 'j', N | NE | W},
+        {3, 'r', N | NE | S},
+
+        {4, 'c', NE | SE | SW | NW},
+        {4, 'e', N | E | S | W},
+        {4, 'k', N | NE | SE | W},
+        {4, 'a', N | NE | E | SE},
+        {4, 'i', N | NE | SE | S},
+        {4, 'n', N | NE | SE | NW},
+        {4, 'y', N | NE | SE | SW},
+        {4, 'q', N | NE | E | SW},
+        {4, 'j', N | E | SE | W},
+        {4, 'r', N | NE | E | S},
+        {4, 't', NW | N | NE | S},
+        {4, 'w', NW | N | E | SE},
+        {4, 'z', N | NE | S | SW}
+};
+
+
+static uint8_t rotate(uint8_t ring) {
+    return (uint8_t) (ring << 2 | ring >> 6);
+}
+
+
+// mirror along the north-south axis
+static uint8_t reflect(uint8_t ring) {
+    uint8_t r = 0;
+    for (int i = 0; i < 8; ++i)
+        r |= (uint8_t) (((ring >> i) & 1) << ((8 - i) & 7));
+    return r;
+}
+
+
+static bool symmetric(uint8_t a, uint8_t b) {
+    for (int i = 0; i < 4; ++i, a = rotate(a)) {
+        if (a == b || reflect(a) == b)
+            return true;
+    }
+    return false;
+}
+
+
+// Hensel letter of a configuration; 0 for none and eight neighbours
+static char letterOf(uint8_t ring) {
+    int count = __builtin_popcount(ring);
+    if (count > 4) {
+        ring = (uint8_t) ~ring;
+        count = 8 - count;
+    }
+
+    for (size_t i = 0; i < sizeof hensel / sizeof *hensel; ++i) {
+        if (hensel[i].count == count && symmetric(hensel[i].ring, ring))
+            return hensel[i].letter;
+    }
+    return 0;
+}
+
+
+static bool validLetter(int count, char letter) {
+    if (count > 4)
+        count = 8 - count;
+    for (size_t i = 0; i < sizeof hensel / sizeof *hensel; ++i) {
+        if (hensel[i].count == count && hensel[i].letter == letter)
+            return true;
+    }
+    return false;
+}
+
+
+// parse the number of states of a Generations rule; return true on error
+static bool parseStates(const char **s, uint16_t *states) {
+    const char *p = *s;
+    if (tolower((unsigned char) *p) == 'c' || tolower((unsigned char) *p) == 'g')
+        ++p;
+    if (!isdigit((unsigned char) *p))
+        return true;
+
+    unsigned n = 0;
+    while (isdigit((unsigned char) *p) && n <= RULES_MAX_STATES)
+        n = n * 10 + (unsigned) (*p++ - '0');
+    if (n < 2 || n > RULES_MAX_STATES)
+        return true;
+
+    *states = (uint16_t) n;
+    *s = p;
+    return false;
+}
+
+
+// parse counts with optional letters and mark the matching configurations; return true on error
+static bool parseCounts(const char **s, bool applies[256]) {
+    const char *p = *s;
+    while (isdigit((unsigned char) *p)) {
+        const int count = *p++ - '0';
+        if (count > 8)
+            return true;
+
+        const bool negate = *p == '-';
+        p += negate;
+        char letters[sizeof HENSEL_LETTERS] = {0};
+        for (size_t len = 0; *p && strchr(HENSEL_LETTERS, tolower((unsigned char) *p)); ++p) {
+            const char letter = (char) tolower((unsigned char) *p);
+            if (!validLetter(count, letter) || len == sizeof letters - 1)
+                return true;
+            letters[len++] = letter;
+        }
+        if (negate && !*letters)
+            return true;
+
+        for (unsigned ring = 0; ring < 256; ++ring) {
+            if (__builtin_popcount(ring) != count)
+                continue;
+            if (!*letters || !!strchr(letters, letterOf((uint8_t) ring)) != negate)
+                applies[ring] = true;
+        }
+    }
+
+    *s = p;
+    return false;
+}
+
+
+bool rules_parse(Rules *rules, const char *s) {
+    bool birth[256] = {0}, survival[256] = {0};
+    uint16_t states = 2;
+    while (isspace((unsigned char) *s))
+        ++s;
+
+    if (tolower((unsigned char) *s) == 'b' || tolower((unsigned char) *s) == 's') {
+        // B/S notation; the parts may come in either order
+        bool seen[2] = {false, false};
+        for (int part = 0; part < 2; ++part) {
+            const bool isBirth = tolower((unsigned char) *s) == 'b';
+            if ((!isBirth && tolower((unsigned char) *s) != 's') || seen[isBirth])
+                return true;
+            seen[isBirth] = true;
+            ++s;
+            if (parseCounts(&s, isBirth ? birth : survival))
+                return true;
+            if (part == 0)
+                s += *s == '/';
+        }
+    } else {
+        // S/B notation
+        if (parseCounts(&s, survival) || *s++ != '/' || parseCounts(&s, birth))
+            return true;
+    }
+
+    if (*s == '/' && (++s, parseStates(&s, &states)))
+        return true;
+
+    while (isspace((unsigned char) *s))
+        ++s;
+    if (*s)
+        return true;
+    // no engine creates the births all over the empty plane that B0 would need
+    if (birth[0])
+        return true;
+
+    for (unsigned i = 0; i < RULES_SIZE; ++i) {
+        uint8_t ring = 0;
+        for (int n = 0; n < 8; ++n) {
+            if (i & RULES_BIT(ringDX[n], ringDY[n]))
+                ring |= (uint8_t) (1 << n);
+        }
+        rules->next[i] = i & RULES_CENTRE ? survival[ring] : birth[ring];
+    }
+    rules->states = states;
+
+    return false;
+}
+
+
+bool rules_totalistic(const Rules *rules) {
+    int next[2][9];
+    memset(next, 0xFF, sizeof next);
+
+    for (unsigned i = 0; i < RULES_SIZE; ++i) {
+        const bool alive = i & RULES_CENTRE;
+        int *seen = &next[alive][__builtin_popcount(i & ~RULES_CENTRE)];
+        if (*seen == -1)
+            *seen = rules->next[i];
+        else if (*seen != rules->next[i])
+            return false;
+    }
+    return true;
+}
+
+
+void rules_counts(const Rules *rules, uint16_t *birth, uint16_t *survival) {
+    *birth = *survival = 0;
+    for (unsigned i = 0; i < RULES_SIZE; ++i) {
+        if (!rules->next[i])
+            continue;
+        const uint16_t bit = (uint16_t) (1 << __builtin_popcount(i & ~RULES_CENTRE));
+        if (i & RULES_CENTRE)
+            *survival |= bit;
+        else
+            *birth |= bit;
+    }
+}
@@ -0,0 +1,70 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_RULES_H
+#define GAMEOFLIFE_RULES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * A rule is compiled into the next state of a cell for every configuration of its 3x3
+ * neighbourhood. Bit 3 * (dx + 1) + (dy + 1) of a neighbourhood holds the cell at offset
+ * (dx, dy) from the centre, so the centre cell itself is bit 4.
+ * Evaluating a cell is a single lookup no matter how complicated the rule is.
+ *
+ * Generations rules add dying states: a live cell (state 1) that does not survive moves to
+ * state 2 and then one state further every generation until it reaches 0 after state
+ * states - 1. Dying cells neither count as neighbours nor can be born into. The table then
+ * only describes cells in state 0 and 1.
+ */
+#define RULES_BIT(dx, dy) (1u << (3 * ((dx) + 1) + (dy) + 1))
+#define RULES_CENTRE RULES_BIT(0, 0)
+#define RULES_SIZE 512
+#define RULES_MAX_STATES 256
+
+typedef struct Rules {
+    uint8_t next[RULES_SIZE];
+    uint16_t states;    // number of cell states; 2 for life-like rules, more for Generations rules
+} Rules;
+
+/**
+ * Next state of a cell.
+ * @param rules rules
+ * @param neighbourhood the cell and its eight neighbours as described above
+ * @return true if the cell is alive in the next generation
+ */
+static inline bool rules_next(const Rules *rules, uint16_t neighbourhood) {
+    return rules->next[neighbourhood];
+}
+
+/**
+ * Compile a rulestring in B/S notation, e.g. "B3/S23", or in the older S/B notation, e.g. "23/3".
+ * Every count may be followed by Hensel letters to restrict it to certain isotropic
+ * configurations, e.g. "B2-a/S12" or "B2ce3/S23". Generations rules append the number of states,
+ * e.g. "B2/S/C3" or "345/2/4". Case and surrounding whitespace are ignored.
+ * Rules with B0, under which empty space gives birth, are rejected.
+ * @param rules receives the compiled rules; untouched on failure
+ * @param s rulestring
+ * @return true if the rulestring is malformed or has B0, false otherwise
+ */
+bool rules_parse(Rules *rules, const char *s);
+
+/**
+ * Whether the next state only depends on the state of a cell and the number of its live neighbours.
+ * @param rules rules
+ * @return true if the rules are outer totalistic
+ */
+bool rules_totalistic(const Rules *rules);
+
+/**
+ * Summarise outer totalistic rules as neighbour counts.
+ * For other rules a count is included if any configuration with that many neighbours applies.
+ * @param rules rules
+ * @param birth receives bit n set if n neighbours give birth
+ * @param survival receives bit n set if n neighbours sustain a cell
+ */
+void rules_counts(const Rules *rules, uint16_t *birth, uint16_t *survival);
+
+#endif //GAMEOFLIFE_RULES_H
@@ -0,0 +1,463 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#define _POSIX_C_SOURCE 200809L
+#include "simulation.h"
+#include "profile.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// set in middle while the frame there has not been taken by the front end yet
+#define FRAME_FRESH 4u
+// seconds over which the generations per second are measured
+#define RATE_WINDOW 0.5
+
+typedef enum EditType {
+    EDIT_CELL, EDIT_CLEAR, EDIT_BACKUP, EDIT_RESTORE, EDIT_RULES
+} EditType;
+
+typedef struct Edit {
+    EditType type;
+    int32_t x, y;
+    unsigned state;
+    char rules[SIM_RULES_LENGTH];
+} Edit;
+
+typedef struct Edits {
+    Edit *edits;
+    uint64_t len, cap;
+} Edits;
+
+typedef struct Snapshot {
+    GOL_Cells *cells;
+    bool hashed;        // whether the engine provides a hash
+    uint64_t hash;
+    uint64_t generation;
+} Snapshot;
+
+typedef struct Bounds {
+    int32_t x0, y0, x1, y1;
+} Bounds;
+
+struct Simulation {
+    GOL_Universe *u;
+    pthread_t thread;
+    double frameInterval;
+
+    // the simulation thread fills frames[back] and the front end reads frames[front];
+    // the third frame is handed between them by exchanging its index with middle
+    Frame frames[3];
+    _Atomic unsigned middle;
+    unsigned back;
+    unsigned front;
+
+    // owned by the simulation thread
+    Snapshot *snapshots;
+    uint64_t snapshotCount, snapshotCap;
+    bool stabilised;    // whether the periodic state of the universe has been reported
+    unsigned exponent;  // hyperspeed batches are 2^exponent generations
+    double gensPerSec;
+
+    // shared, guarded by lock
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    Edits pending;
+    Bounds view;        // requested by the front end
+    Bounds gathered;    // bounds of the latest frame
+    bool viewChanged;   // the view is not covered by the latest frame
+    uint64_t tickrate;
+    bool paused;
+    bool hyperspeed;
+    bool quit;
+};
+
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec / 1e9;
+}
+
+
+static int32_t clamp32(int64_t v) {
+    return v < INT32_MIN ? INT32_MIN : v > INT32_MAX ? INT32_MAX : (int32_t) v;
+}
+
+
+// the bounds plus half their size on every side
+static Bounds withMargin(Bounds b) {
+    const int64_t mx = ((int64_t) b.x1 - b.x0) / 2 + 1, my = ((int64_t) b.y1 - b.y0) / 2 + 1;
+    return (Bounds) {clamp32(b.x0 - mx), clamp32(b.y0 - my), clamp32(b.x1 + mx), clamp32(b.y1 + my)};
+}
+
+
+static bool covers(Bounds outer, Bounds inner) {
+    return outer.x0 <= inner.x0 && outer.y0 <= inner.y0 && inner.x1 <= outer.x1 && inner.y1 <= outer.y1;
+}
+
+
+static void gatherCell(int32_t x, int32_t y, unsigned state, void *frame) {
+    Frame *f = frame;
+    if (f->len == f->cap) {
+        const uint64_t cap = f->cap ? f->cap * 2 : 1024;
+        FrameCell *grown = realloc(f->cells, cap * sizeof *grown);
+        if (!grown) {
+            fprintf(stderr, "Could not allocate memory for a frame.\n");
+            abort();
+        }
+        f->cells = grown;
+        f->cap = cap;
+    }
+    f->cells[f->len++] = (FrameCell) {x, y, state};
+}
+
+
+// fill the back frame and hand it to the front end
+static void publish(Simulation *sim, Bounds b, uint64_t batch) {
+    ProfileMark start, end;
+    trace_begin("publish");
+    prof_mark(&start);
+    Frame *f = &sim->frames[sim->back];
+    f->len = 0;
+    f->x0 = b.x0;
+    f->y0 = b.y0;
+    f->x1 = b.x1;
+    f->y1 = b.y1;
+    f->generation = gol_generation(sim->u);
+    f->states = gol_states(sim->u);
+    f->batch = batch;
+    f->gensPerSec = sim->gensPerSec;
+    gol_forEachInRect(sim->u, b.x0, b.y0, b.x1, b.y1, gatherCell, f);
+    prof_mark(&end);
+    prof_record(PROF_PUBLISH, &start, &end, f->len);
+    sim->back = atomic_exchange(&sim->middle, sim->back | FRAME_FRESH) & ~FRAME_FRESH;
+    trace_end("publish");
+}
+
+
+static void backup(Simulation *sim) {
+    if (sim->snapshotCount == sim->snapshotCap) {
+        const uint64_t cap = sim->snapshotCap ? sim->snapshotCap * 2 : 8;
+        Snapshot *grown = realloc(sim->snapshots, cap * sizeof *grown);
+        if (!grown) {
+            fprintf(stderr, "Could not allocate memory for a snapshot.\n");
+            return;
+        }
+        sim->snapshots = grown;
+        sim->snapshotCap = cap;
+    }
+
+    Snapshot *snapshot = &sim->snapshots[sim->snapshotCount++];
+    snapshot->cells = gol_capture(sim->u);
+    snapshot->hashed = gol_hash(sim->u, &snapshot->hash);
+    snapshot->generation = gol_generation(sim->u);
+}
+
+
+static void restore(Simulation *sim) {
+    if (!sim->snapshotCount)
+        return;
+
+    Snapshot *snapshot = &sim->snapshots[--sim->snapshotCount];
+    // equal hashes mean the universe is still in the stored state, which is common while paused
+    uint64_t hash;
+    if (!snapshot->hashed || !gol_hash(sim->u, &hash) || hash != snapshot->hash) {
+        gol_clear(sim->u);
+        gol_load(sim->u, snapshot->cells);
+    }
+    gol_setGeneration(sim->u, snapshot->generation);
+    gol_freeCells(snapshot->cells);
+}
+
+
+static void applyEdit(Simulation *sim, const Edit *edit) {
+    switch (edit->type) {
+    case EDIT_CELL:
+        gol_setCell(sim->u, edit->x, edit->y, edit->state);
+        break;
+    case EDIT_CLEAR:
+        gol_clear(sim->u);
+        break;
+    case EDIT_BACKUP:
+        backup(sim);
+        break;
+    case EDIT_RESTORE:
+        restore(sim);
+        break;
+    case EDIT_RULES:
+        gol_setRules(sim->u, edit->rules);
+        break;
+    }
+}
+
+
+static uint64_t advance(Simulation *sim, uint64_t due) {
+    const uint64_t advanced = gol_advance(sim->u, due);
+    uint64_t period, since;
+    const bool periodic = gol_period(sim->u, &period, &since);
+    if (periodic && !sim->stabilised)
+        printf("Stabilised at generation %llu with period %llu.\n", (unsigned long long) since, (unsigned long long) period);
+    sim->stabilised = periodic;
+    return advanced;
+}
+
+
+// compute a batch of 2^exponent generations and adapt the exponent, so that the next batch takes about
+// as long as a frame: it doubles while a batch takes less than half a frame and halves once it takes longer
+static void hyperspeed(Simulation *sim) {
+    const double start = now();
+    trace_begin("batch");
+    for (uint64_t left = (uint64_t) 1 << sim->exponent; left; )
+        left -= advance(sim, left);
+    trace_end("batch");
+
+    const double seconds = now() - start;
+    if (seconds < sim->frameInterval / 2 && sim->exponent < SIM_MAX_EXPONENT)
+        ++sim->exponent;
+    else if (seconds > sim->frameInterval && sim->exponent)
+        --sim->exponent;
+}
+
+
+static void *run(void *arg) {
+    Simulation *sim = arg;
+    Edits edits = {0};
+    double due = 0;         // generations due, including the elapsed fraction of the next one
+    double last = now();    // when due was last brought up to date
+    double published = 0;   // when the latest frame was published
+    bool running = false;   // whether the simulation was running since last
+    bool wasFast = false;   // whether the previous round ran in hyperspeed mode
+    bool changed = true;    // whether the universe changed since the latest frame
+    double rateStart = last;
+    uint64_t rateGeneration = 0;
+
+    trace_nameThread("simulation");
+    pthread_mutex_lock(&sim->lock);
+    while (!sim->quit) {
+        // take over the queued edits, leaving the emptied list of the previous round for new ones
+        const Edits queued = sim->pending;
+        sim->pending = edits;
+        edits = queued;
+        const bool paused = sim->paused, fast = sim->hyperspeed, viewChanged = sim->viewChanged;
+        const uint64_t tickrate = sim->tickrate;
+        const Bounds view = withMargin(sim->view);
+        sim->viewChanged = false;
+        pthread_mutex_unlock(&sim->lock);
+
+        if (edits.len) {
+            trace_begin("edits");
+            for (uint64_t i = 0; i < edits.len; ++i)
+                applyEdit(sim, &edits.edits[i]);
+            trace_end("edits");
+        }
+        changed |= edits.len != 0;
+        edits.len = 0;
+
+        // spend at most a frame interval on generations before looking at edits and the view again
+        const double start = now();
+        if (running && !paused && !fast)
+            due += (start - last) * (double) tickrate;
+        last = start;
+        running = !paused;
+        changed |= fast != wasFast;
+        wasFast = fast;
+        if (fast && !paused) {
+            hyperspeed(sim);
+            changed = true;
+        }
+        while (due >= 1 && !paused && !fast && now() - start < sim->frameInterval) {
+            due -= (double) advance(sim, (uint64_t) due);
+            changed = true;
+        }
+
+        // edits and restored snapshots change the generation as well, which only skews a single window
+        const uint64_t generation = gol_generation(sim->u);
+        if (paused || generation < rateGeneration) {
+            sim->gensPerSec = 0;
+            rateStart = now();
+            rateGeneration = generation;
+        } else if (now() - rateStart >= RATE_WINDOW) {
+            sim->gensPerSec = (double) (generation - rateGeneration) / (now() - rateStart);
+            rateStart = now();
+            rateGeneration = generation;
+        }
+
+        const bool publishing = viewChanged || (changed && now() - published >= sim->frameInterval);
+        if (publishing) {
+            publish(sim, view, fast ? (uint64_t) 1 << sim->exponent : 0);
+            published = now();
+            changed = false;
+        }
+
+        pthread_mutex_lock(&sim->lock);
+        if (publishing)
+            sim->gathered = view;
+        if (sim->quit || sim->pending.len || sim->viewChanged || sim->paused != paused || sim->hyperspeed != fast)
+            continue;
+
+        // sleep until the next generation or batch is due or a frame may be published again
+        double wakeAt = INFINITY;
+        if (!paused && fast)
+            wakeAt = start + sim->frameInterval;
+        else if (!paused)
+            wakeAt = due >= 1 ? 0 : last + (1 - due) / (double) sim->tickrate;
+        if (changed)
+            wakeAt = fmin(wakeAt, published + sim->frameInterval);
+        if (wakeAt == INFINITY) {
+            pthread_cond_wait(&sim->wake, &sim->lock);
+        } else if (wakeAt > now()) {
+            const struct timespec deadline = {(time_t) wakeAt, (long) ((wakeAt - floor(wakeAt)) * 1e9)};
+            pthread_cond_timedwait(&sim->wake, &sim->lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&sim->lock);
+
+    free(edits.edits);
+    return NULL;
+}
+
+
+Simulation *sim_create(GOL_Universe *u, uint64_t tickrate, double frameInterval) {
+    Simulation *sim = calloc(1, sizeof *sim);
+    if (!sim) return NULL;
+
+    sim->u = u;
+    sim->frameInterval = frameInterval;
+    sim->front = 0;
+    atomic_init(&sim->middle, 1);
+    sim->back = 2;
+    sim->gathered = (Bounds) {1, 1, 0, 0};  // covers nothing
+    sim->tickrate = tickrate ? tickrate : 1;
+    sim->paused = true;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&sim->lock, NULL);
+    pthread_cond_init(&sim->wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&sim->thread, NULL, run, sim)) {
+        pthread_cond_destroy(&sim->wake);
+        pthread_mutex_destroy(&sim->lock);
+        free(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+
+void sim_destroy(Simulation *sim) {
+    if (!sim) return;
+
+    pthread_mutex_lock(&sim->lock);
+    sim->quit = true;
+    pthread_cond_signal(&sim->wake);
+    pthread_mutex_unlock(&sim->lock);
+    pthread_join(sim->thread, NULL);
+
+    for (uint64_t i = 0; i < sim->snapshotCount; ++i)
+        gol_freeCells(sim->snapshots[i].cells);
+    for (int i = 0; i < 3; ++i)
+        free(sim->frames[i].cells);
+    free(sim->snapshots);
+    free(sim->pending.edits);
+    pthread_cond_destroy(&sim->wake);
+    pthread_mutex_destroy(&sim->lock);
+    free(sim);
+}
+
+
+const Frame *sim_frame(Simulation *sim) {
+    if (atomic_load_explicit(&sim->middle, memory_order_relaxed) & FRAME_FRESH)
+        sim->front = atomic_exchange(&sim->middle, sim->front) & ~FRAME_FRESH;
+    return &sim->frames[sim->front];
+}
+
+
+void sim_setView(Simulation *sim, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    pthread_mutex_lock(&sim->lock);
+    sim->view = (Bounds) {x0, y0, x1, y1};
+    if (!covers(sim->gathered, sim->view)) {
+        sim->viewChanged = true;
+        pthread_cond_signal(&sim->wake);
+    }
+    pthread_mutex_unlock(&sim->lock);
+}
+
+
+void sim_setPaused(Simulation *sim, bool paused) {
+    pthread_mutex_lock(&sim->lock);
+    sim->paused = paused;
+    pthread_cond_signal(&sim->wake);
+    pthread_mutex_unlock(&sim->lock);
+}
+
+
+void sim_setHyperspeed(Simulation *sim, bool hyperspeed) {
+    pthread_mutex_lock(&sim->lock);
+    sim->hyperspeed = hyperspeed;
+    pthread_cond_signal(&sim->wake);
+    pthread_mutex_unlock(&sim->lock);
+}
+
+
+void sim_setTickrate(Simulation *sim, uint64_t tickrate) {
+    pthread_mutex_lock(&sim->lock);
+    sim->tickrate = tickrate ? tickrate : 1;
+    pthread_cond_signal(&sim->wake);
+    pthread_mutex_unlock(&sim->lock);
+}
+
+
+static void queueEdit(Simulation *sim, const Edit *edit) {
+    pthread_mutex_lock(&sim->lock);
+    Edits *pending = &sim->pending;
+    if (pending->len == pending->cap) {
+        const uint64_t cap = pending->cap ? pending->cap * 2 : 64;
+        Edit *grown = realloc(pending->edits, cap * sizeof *grown);
+        if (!grown) {
+            fprintf(stderr, "Could not allocate memory for an edit.\n");
+            abort();
+        }
+        pending->edits = grown;
+        pending->cap = cap;
+    }
+    pending->edits[pending->len++] = *edit;
+    pthread_cond_signal(&sim->wake);
+    pthread_mutex_unlock(&sim->lock);
+}
+
+
+void sim_setCell(Simulation *sim, int32_t x, int32_t y, unsigned state) {
+    queueEdit(sim, &(Edit) {.type = EDIT_CELL, .x = x, .y = y, .state = state});
+}
+
+
+void sim_clear(Simulation *sim) {
+    queueEdit(sim, &(Edit) {.type = EDIT_CLEAR});
+}
+
+
+void sim_backup(Simulation *sim) {
+    queueEdit(sim, &(Edit) {.type = EDIT_BACKUP});
+}
+
+
+void sim_restore(Simulation *sim) {
+    queueEdit(sim, &(Edit) {.type = EDIT_RESTORE});
+}
+
+
+void sim_setRules(Simulation *sim, const char *rulestring) {
+    Edit edit = {.type = EDIT_RULES};
+    snprintf(edit.rules, sizeof edit.rules, "%s", rulestring);
+    queueEdit(sim, &edit);
+}
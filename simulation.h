@@ -0,0 +1,122 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_SIMULATION_H
+#define GAMEOFLIFE_SIMULATION_H
+
+#include "gol.h"
+
+#define SIM_RULES_LENGTH 64
+#define SIM_MAX_EXPONENT 40     // largest hyperspeed batch is 2^SIM_MAX_EXPONENT generations
+
+/*
+ * Runs a universe on a thread of its own, so that neither slow generations hold up input and
+ * rendering nor rendering holds up the simulation. The simulation thread publishes frames, which
+ * are immutable copies of the cells around the requested view, through a lock-free triple buffer.
+ * Edits are queued and applied between generations, in the order they were made.
+ * In hyperspeed mode the tick rate is ignored; instead a batch of 2^k generations is computed for
+ * every frame, where k grows and shrinks so that a batch takes about one frame interval.
+ * All functions are meant to be called from a single thread, the front end.
+ */
+typedef struct Simulation Simulation;
+
+typedef struct FrameCell {
+    int32_t x, y;
+    unsigned state;
+} FrameCell;
+
+typedef struct Frame {
+    FrameCell *cells;
+    uint64_t len, cap;
+    int32_t x0, y0, x1, y1;     // inclusive bounds the cells were gathered from
+    uint64_t generation;
+    unsigned states;            // number of cell states of the rules
+    uint64_t batch;             // generations per frame in hyperspeed mode, 0 otherwise
+    double gensPerSec;          // generations computed per second recently; 0 while paused
+} Frame;
+
+/**
+ * Start simulating a universe. The simulation starts paused.
+ * @param u universe; must not be used by the caller until sim_destroy()
+ * @param tickrate generations per second
+ * @param frameInterval minimum seconds between frames published for a changing world
+ * @return new simulation or NULL if the thread could not be started
+ */
+Simulation *sim_create(GOL_Universe *u, uint64_t tickrate, double frameInterval);
+
+/**
+ * Stop the simulation thread and free the simulation. The universe is left to the caller. NULL is ignored.
+ * @param sim simulation
+ */
+void sim_destroy(Simulation *sim);
+
+/**
+ * Latest frame published. Frames are only exchanged by this function, so the frame returned
+ * stays valid and unchanged until the next call.
+ * @param sim simulation
+ * @return latest frame; empty until the first one is published
+ */
+const Frame *sim_frame(Simulation *sim);
+
+/**
+ * Request the cells within the inclusive bounds. A new frame is published if the bounds are not
+ * covered by the latest frame; a margin around the bounds is gathered so that small moves of the
+ * view are covered as well.
+ * @param sim simulation
+ * @param x0, y0, x1, y1 inclusive bounds
+ */
+void sim_setView(Simulation *sim, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+
+/**
+ * @param sim simulation
+ * @param paused whether generations should be computed
+ */
+void sim_setPaused(Simulation *sim, bool paused);
+
+/**
+ * @param sim simulation
+ * @param tickrate generations per second; at least 1
+ */
+void sim_setTickrate(Simulation *sim, uint64_t tickrate);
+
+/**
+ * @param sim simulation
+ * @param hyperspeed whether to compute exponentially growing batches of generations per frame
+ */
+void sim_setHyperspeed(Simulation *sim, bool hyperspeed);
+
+/**
+ * Queue setting the state of a cell.
+ * @param sim simulation
+ * @param x, y coordinates
+ * @param state new state
+ */
+void sim_setCell(Simulation *sim, int32_t x, int32_t y, unsigned state);
+
+/**
+ * Queue killing every cell.
+ * @param sim simulation
+ */
+void sim_clear(Simulation *sim);
+
+/**
+ * Queue storing a snapshot of the universe on a stack.
+ * @param sim simulation
+ */
+void sim_backup(Simulation *sim);
+
+/**
+ * Queue restoring the most recently stored snapshot, which is removed from the stack.
+ * @param sim simulation
+ */
+void sim_restore(Simulation *sim);
+
+/**
+ * Queue replacing the rules. Invalid rules are reported to stderr by the simulation thread.
+ * @param sim simulation
+ * @param rulestring new rules; cut off after SIM_RULES_LENGTH - 1 characters
+ */
+void sim_setRules(Simulation *sim, const char *rulestring);
+
+#endif //GAMEOFLIFE_SIMULATION_H
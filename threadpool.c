@@ -0,0 +1,218 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "threadpool.h"
+#include "trace.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/*
+ * Every thread owns a deque of task indices. Since tasks are only ever removed during a run,
+ * a deque is just the range [top, bottom), packed into one atomic word so that owner and
+ * thieves can both claim a task with a single compare-and-swap.
+ */
+typedef struct Deque {
+    _Alignas(64) _Atomic uint64_t range;    // top in the upper, bottom in the lower 32 bits
+} Deque;
+
+struct threadpool {
+    pthread_t *workers;
+    Deque *deques;
+    unsigned threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t epoch;         // incremented for every run
+    unsigned active;        // workers still busy with the current run
+    bool shutdown;
+
+    void (*f)(uint64_t, unsigned, void *);
+    void *arg;
+};
+
+struct WorkerArgs {
+    threadpool *tp;
+    unsigned thread;
+};
+
+
+static uint64_t packRange(uint32_t top, uint32_t bottom) {
+    return (uint64_t) top << 32 | bottom;
+}
+
+
+// take a task from the back of the own deque; return false if it is empty
+static bool popOwn(Deque *d, uint32_t *task) {
+    uint64_t range = atomic_load_explicit(&d->range, memory_order_relaxed);
+    for (;;) {
+        const uint32_t top = range >> 32, bottom = (uint32_t) range;
+        if (top >= bottom)
+            return false;
+        if (atomic_compare_exchange_weak(&d->range, &range, packRange(top, bottom - 1))) {
+            *task = bottom - 1;
+            return true;
+        }
+    }
+}
+
+
+// take a task from the front of another thread's deque; return false if it is empty
+static bool steal(Deque *d, uint32_t *task) {
+    uint64_t range = atomic_load_explicit(&d->range, memory_order_relaxed);
+    for (;;) {
+        const uint32_t top = range >> 32, bottom = (uint32_t) range;
+        if (top >= bottom)
+            return false;
+        if (atomic_compare_exchange_weak(&d->range, &range, packRange(top + 1, bottom))) {
+            *task = top;
+            return true;
+        }
+    }
+}
+
+
+static void work(threadpool *tp, unsigned thread) {
+    uint32_t task;
+    for (;;) {
+        while (popOwn(&tp->deques[thread], &task))
+            tp->f(task, thread, tp->arg);
+
+        bool stolen = false;
+        for (unsigned i = 1; i < tp->threads && !stolen; ++i) {
+            if (steal(&tp->deques[(thread + i) % tp->threads], &task)) {
+                tp->f(task, thread, tp->arg);
+                stolen = true;
+            }
+        }
+
+        if (!stolen)
+            return;
+    }
+}
+
+
+static void *workerMain(void *args_) {
+    struct WorkerArgs *args = args_;
+    threadpool *tp = args->tp;
+    const unsigned thread = args->thread;
+    free(args);
+
+    trace_nameThread("worker");
+    uint64_t seen = 0;
+    pthread_mutex_lock(&tp->lock);
+    for (;;) {
+        while (tp->epoch == seen && !tp->shutdown)
+            pthread_cond_wait(&tp->start, &tp->lock);
+        if (tp->shutdown)
+            break;
+        seen = tp->epoch;
+        pthread_mutex_unlock(&tp->lock);
+
+        trace_begin("work");
+        work(tp, thread);
+        trace_end("work");
+
+        pthread_mutex_lock(&tp->lock);
+        if (--tp->active == 0)
+            pthread_cond_signal(&tp->done);
+    }
+    pthread_mutex_unlock(&tp->lock);
+    return NULL;
+}
+
+
+threadpool *tp_new(unsigned threads) {
+    threads = threads ? threads : 1;
+    threadpool *tp = heap_calloc(1, sizeof *tp);
+    if (!tp) return NULL;
+
+    tp->threads = threads;
+    tp->workers = heap_calloc(threads, sizeof *tp->workers);
+    tp->deques = heap_alignedAlloc(_Alignof(Deque), threads * sizeof *tp->deques);
+    if (!tp->workers || !tp->deques) {
+        free(tp->workers);
+        free(tp->deques);
+        free(tp);
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < threads; ++i)
+        atomic_init(&tp->deques[i].range, 0);
+    pthread_mutex_init(&tp->lock, NULL);
+    pthread_cond_init(&tp->start, NULL);
+    pthread_cond_init(&tp->done, NULL);
+
+    for (unsigned i = 1; i < threads; ++i) {
+        struct WorkerArgs *args = heap_malloc(sizeof *args);
+        if (args) *args = (struct WorkerArgs) {tp, i};
+        if (!args || pthread_create(&tp->workers[i], NULL, workerMain, args)) {
+            free(args);
+            tp->threads = i;    // only join the workers started so far
+            tp_destroy(tp);
+            return NULL;
+        }
+    }
+
+    return tp;
+}
+
+
+void tp_destroy(threadpool *tp) {
+    if (!tp) return;
+
+    pthread_mutex_lock(&tp->lock);
+    tp->shutdown = true;
+    pthread_cond_broadcast(&tp->start);
+    pthread_mutex_unlock(&tp->lock);
+
+    for (unsigned i = 1; i < tp->threads; ++i)
+        pthread_join(tp->workers[i], NULL);
+
+    pthread_mutex_destroy(&tp->lock);
+    pthread_cond_destroy(&tp->start);
+    pthread_cond_destroy(&tp->done);
+    free(tp->workers);
+    free(tp->deques);
+    free(tp);
+}
+
+
+unsigned tp_threads(const threadpool *tp) {
+    return tp->threads;
+}
+
+
+void tp_run(threadpool *tp, uint64_t tasks, void (*f)(uint64_t, unsigned, void *), void *arg) {
+    if (tp->threads == 1 || tasks < 2) {
+        for (uint64_t i = 0; i < tasks; ++i)
+            f(i, 0, arg);
+        return;
+    }
+
+    for (unsigned i = 0; i < tp->threads; ++i) {
+        const uint32_t top = (uint32_t) (tasks * i / tp->threads);
+        const uint32_t bottom = (uint32_t) (tasks * (i + 1) / tp->threads);
+        atomic_store(&tp->deques[i].range, packRange(top, bottom));
+    }
+
+    pthread_mutex_lock(&tp->lock);
+    tp->f = f;
+    tp->arg = arg;
+    tp->active = tp->threads - 1;
+    ++tp->epoch;
+    pthread_cond_broadcast(&tp->start);
+    pthread_mutex_unlock(&tp->lock);
+
+    work(tp, 0);
+
+    // barrier: the run is over once every worker has found all deques empty
+    pthread_mutex_lock(&tp->lock);
+    while (tp->active)
+        pthread_cond_wait(&tp->done, &tp->lock);
+    pthread_mutex_unlock(&tp->lock);
+}
@@ -0,0 +1,48 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_THREADPOOL_H
+#define GAMEOFLIFE_THREADPOOL_H
+
+#include <stdint.h>
+
+/*
+ * Fixed pool of worker threads for data-parallel loops. The tasks of a run are split into one
+ * contiguous block per thread; each thread works through its own block from the back and, once
+ * it runs dry, steals single tasks from the front of the other threads' blocks.
+ * The calling thread takes part in every run as thread 0.
+ */
+typedef struct threadpool threadpool;
+
+/**
+ * Create a thread pool.
+ * @param threads total number of threads including the calling thread; 0 is treated as 1
+ * @return new thread pool or NULL if out of memory or threads could not be started
+ */
+threadpool *tp_new(unsigned threads);
+
+/**
+ * Stop all workers and free the pool. NULL is ignored.
+ * @param tp thread pool
+ */
+void tp_destroy(threadpool *tp);
+
+/**
+ * @param tp thread pool
+ * @return total number of threads including the calling thread
+ */
+unsigned tp_threads(const threadpool *tp);
+
+/**
+ * Call f(task, thread, arg) for every task in [0, tasks) and return once all calls have completed.
+ * thread is the index of the calling thread in [0, tp_threads()), which lets tasks use per-thread scratch space.
+ * A run must not be started from within a task.
+ * @param tp thread pool
+ * @param tasks number of tasks; must fit into 32 bits
+ * @param f task function
+ * @param arg argument passed to f
+ */
+void tp_run(threadpool *tp, uint64_t tasks, void (*f)(uint64_t task, unsigned thread, void *arg), void *arg);
+
+#endif //GAMEOFLIFE_THREADPOOL_H
@@ -0,0 +1,76 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "tilekernel.h"
+#include <stddef.h>
+#include <string.h>
+
+#define KERNEL_NAME kernelScalar
+#define KERNEL_BYTES 8
+#include "tilekernel_impl.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_NAME kernelSSE2
+#define KERNEL_BYTES 16
+#define KERNEL_TARGET "sse2"
+#include "tilekernel_impl.h"
+
+#define KERNEL_NAME kernelAVX2
+#define KERNEL_BYTES 32
+#define KERNEL_TARGET "avx2"
+#include "tilekernel_impl.h"
+
+#define KERNEL_NAME kernelAVX512
+#define KERNEL_BYTES 64
+#define KERNEL_TARGET "avx512f"
+#include "tilekernel_impl.h"
+#endif
+
+
+static TileKernel chosen;
+static const char *chosenName;
+
+
+TileKernel tileKernel_select(const char **name) {
+    if (!chosen) {
+        chosen = kernelScalar;
+        chosenName = "scalar";
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            chosen = kernelAVX512;
+            chosenName = "avx512";
+        } else if (__builtin_cpu_supports("avx2")) {
+            chosen = kernelAVX2;
+            chosenName = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            chosen = kernelSSE2;
+            chosenName = "sse2";
+        }
+#endif
+    }
+
+    if (name) *name = chosenName;
+    return chosen;
+}
+
+
+void tileKernel_lookup(const uint64_t *l, const uint64_t *m, const uint64_t *r, uint64_t *out, const Rules *rules) {
+    for (int i = 0; i < TILE_SIZE; ++i) {
+        // l, m and r of one row are the columns dx = -1, 0, 1 of the neighbourhood
+        const uint64_t rows[9] = {l[i], l[i + 1], l[i + 2], m[i], m[i + 1], m[i + 2], r[i], r[i + 1], r[i + 2]};
+        uint64_t any = 0;
+        for (int b = 0; b < 9; ++b)
+            any |= rows[b];
+
+        uint64_t next = 0;
+        for (int x = 0; x < TILE_SIZE && any >> x; ++x) {
+            uint16_t neighbourhood = 0;
+            for (int b = 0; b < 9; ++b)
+                neighbourhood |= (uint16_t) (((rows[b] >> x) & 1) << b);
+            next |= (uint64_t) rules_next(rules, neighbourhood) << x;
+        }
+        out[i] = next;
+    }
+}
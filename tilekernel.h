@@ -0,0 +1,39 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_TILEKERNEL_H
+#define GAMEOFLIFE_TILEKERNEL_H
+
+#include "rules.h"
+#include <stdint.h>
+
+#define TILE_BITS 6
+#define TILE_SIZE (1 << TILE_BITS)
+
+/*
+ * Compute the next generation of the 64 rows of a tile. All input arrays hold 66 rows: the row above
+ * the tile, the tile's rows and the row below. m holds the cells themselves, l the cells to their
+ * west (m shifted by one towards higher x) and r those to their east. Bit n of birth and survival
+ * is set if n live neighbours give birth to or sustain a cell respectively.
+ */
+typedef void (*TileKernel)(const uint64_t *l, const uint64_t *m, const uint64_t *r, uint64_t *out,
+                           uint16_t birth, uint16_t survival);
+
+/**
+ * Pick the widest kernel the CPU supports. The choice is made once at the first call.
+ * @param name if not NULL, receives the name of the instruction set used
+ * @return tile kernel
+ */
+TileKernel tileKernel_select(const char **name);
+
+/**
+ * Compute the next generation like a TileKernel, but for arbitrary rules: every cell looks up its
+ * neighbourhood in the rule table. Much slower than the counting kernels, which only cover outer
+ * totalistic rules. The rules must not give birth in an empty neighbourhood.
+ * @param l, m, r, out as for TileKernel
+ * @param rules rules
+ */
+void tileKernel_lookup(const uint64_t *l, const uint64_t *m, const uint64_t *r, uint64_t *out, const Rules *rules);
+
+#endif //GAMEOFLIFE_TILEKERNEL_H
@@ -0,0 +1,64 @@
+//
+// Created by easy on 16.10.26.
+//
+
+/*
+ * Body of a tile kernel, included once per instruction set by tilekernel.c.
+ * Expects KERNEL_NAME, KERNEL_BYTES (vector width in bytes) and optionally KERNEL_TARGET to be defined.
+ * The vector type is a GCC vector extension, so the same code is emitted as scalar, SSE2, AVX2 or
+ * AVX-512 instructions depending on the target attribute of the function.
+ */
+
+#define KERNEL_LANES (KERNEL_BYTES / 8)
+#define KERNEL_VEC KERNEL_JOIN(KERNEL_NAME, _vec)
+#define KERNEL_JOIN(a, b) KERNEL_JOIN_(a, b)
+#define KERNEL_JOIN_(a, b) a ## b
+
+typedef uint64_t KERNEL_VEC __attribute__((vector_size(KERNEL_BYTES)));
+
+#ifdef KERNEL_TARGET
+__attribute__((target(KERNEL_TARGET)))
+#endif
+static void KERNEL_NAME(const uint64_t *l, const uint64_t *m, const uint64_t *r, uint64_t *out,
+                        uint16_t birth, uint16_t survival) {
+    for (int i = 0; i < TILE_SIZE; i += KERNEL_LANES) {
+        KERNEL_VEC a, b, c, d, alive, e, f, g, h;
+        memcpy(&a, l + i, KERNEL_BYTES);
+        memcpy(&b, m + i, KERNEL_BYTES);
+        memcpy(&c, r + i, KERNEL_BYTES);
+        memcpy(&d, l + i + 1, KERNEL_BYTES);
+        memcpy(&alive, m + i + 1, KERNEL_BYTES);
+        memcpy(&e, r + i + 1, KERNEL_BYTES);
+        memcpy(&f, l + i + 2, KERNEL_BYTES);
+        memcpy(&g, m + i + 2, KERNEL_BYTES);
+        memcpy(&h, r + i + 2, KERNEL_BYTES);
+
+        // full adders over the eight neighbours
+        const KERNEL_VEC s1 = a ^ b ^ c, c1 = (a & b) | (c & (a ^ b));
+        const KERNEL_VEC s2 = d ^ e ^ f, c2 = (d & e) | (f & (d ^ e));
+        const KERNEL_VEC s3 = g ^ h, c3 = g & h;
+        const KERNEL_VEC bit0 = s1 ^ s2 ^ s3, c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+        const KERNEL_VEC t0 = c1 ^ c2 ^ c3, t1 = (c1 & c2) | (c3 & (c1 ^ c2));
+        const KERNEL_VEC bit1 = t0 ^ c4, c5 = t0 & c4;
+        const KERNEL_VEC bit2 = t1 ^ c5, bit3 = t1 & c5;
+
+        KERNEL_VEC next = alive ^ alive;
+        for (int n = 0; n <= 8; ++n) {
+            if (!(((birth | survival) >> n) & 1))
+                continue;
+            const KERNEL_VEC eq = (n & 1 ? bit0 : ~bit0) & (n & 2 ? bit1 : ~bit1)
+                                & (n & 4 ? bit2 : ~bit2) & (n & 8 ? bit3 : ~bit3);
+            if ((birth >> n) & 1)
+                next |= eq & ~alive;
+            if ((survival >> n) & 1)
+                next |= eq & alive;
+        }
+        memcpy(out + i, &next, KERNEL_BYTES);
+    }
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_BYTES
+#undef KERNEL_TARGET
+#undef KERNEL_LANES
+#undef KERNEL_VEC
@@ -0,0 +1,159 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#define _POSIX_C_SOURCE 200809L
+#include "trace.h"
+#include "heap.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+typedef struct Event {
+    _Atomic uint64_t ns;
+    _Atomic(const char *) name;
+    _Atomic bool end;
+} Event;
+
+typedef struct Ring {
+    Event events[TRACE_EVENTS];         // indexed by count modulo TRACE_EVENTS
+    _Atomic uint64_t count;
+    _Atomic(const char *) thread;       // NULL if the thread has no name
+} Ring;
+
+static _Atomic(Ring *) rings;
+static _Atomic unsigned ringCount;      // rings claimed, may exceed TRACE_THREADS
+static _Atomic bool enabled;
+static _Atomic uint64_t origin;         // ns of the first trace_enable(), time 0 of the trace
+static _Thread_local Ring *ring;
+static _Thread_local bool untraced;     // the thread came too late for a ring
+static _Thread_local const char *threadName;
+
+
+static uint64_t nowNs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000u + (uint64_t) t.tv_nsec;
+}
+
+
+bool trace_enable(void) {
+    if (!atomic_load(&rings)) {
+        // every page is touched now, so that recording never has to fault one in
+        Ring *all = heap_malloc(TRACE_THREADS * sizeof *all);
+        if (!all)
+            return true;
+        memset(all, 0, TRACE_THREADS * sizeof *all);
+        atomic_store(&origin, nowNs());
+        atomic_store(&rings, all);
+    }
+    atomic_store(&enabled, true);
+    return false;
+}
+
+
+bool trace_enabled(void) {
+    return atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+
+// ring of the calling thread, claimed on first use; NULL if it has none
+static Ring *claim(void) {
+    if (ring || untraced)
+        return ring;
+    Ring *all = atomic_load_explicit(&rings, memory_order_acquire);
+    if (!all)
+        return NULL;
+
+    const unsigned index = atomic_fetch_add(&ringCount, 1);
+    if (index >= TRACE_THREADS) {
+        untraced = true;
+        return NULL;
+    }
+    ring = &all[index];
+    atomic_store_explicit(&ring->thread, threadName, memory_order_relaxed);
+    return ring;
+}
+
+
+static void record(const char *name, bool end) {
+    if (!trace_enabled())
+        return;
+    Ring *r = claim();
+    if (!r)
+        return;
+
+    // the only writer of the ring; release publishes the event
+    const uint64_t count = atomic_load_explicit(&r->count, memory_order_relaxed);
+    Event *e = &r->events[count % TRACE_EVENTS];
+    atomic_store_explicit(&e->ns, nowNs(), memory_order_relaxed);
+    atomic_store_explicit(&e->name, name, memory_order_relaxed);
+    atomic_store_explicit(&e->end, end, memory_order_relaxed);
+    atomic_store_explicit(&r->count, count + 1, memory_order_release);
+}
+
+
+void trace_begin(const char *name) {
+    record(name, false);
+}
+
+
+void trace_end(const char *name) {
+    record(name, true);
+}
+
+
+void trace_nameThread(const char *name) {
+    threadName = name;
+    if (ring)
+        atomic_store_explicit(&ring->thread, name, memory_order_relaxed);
+}
+
+
+// write the events of a ring, oldest first; return whether any event was written before
+static bool writeRing(FILE *f, Ring *r, unsigned tid, uint64_t start, bool first) {
+    const char *thread = atomic_load_explicit(&r->thread, memory_order_relaxed);
+    if (thread) {
+        fprintf(f, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                first ? "" : ",", tid, thread);
+        first = false;
+    }
+
+    const uint64_t count = atomic_load_explicit(&r->count, memory_order_acquire);
+    unsigned depth = 0;     // spans begun and not ended yet among the events written
+    for (uint64_t i = count > TRACE_EVENTS ? count - TRACE_EVENTS : 0; i < count; ++i) {
+        const Event *e = &r->events[i % TRACE_EVENTS];
+        const uint64_t ns = atomic_load_explicit(&e->ns, memory_order_relaxed);
+        const char *name = atomic_load_explicit(&e->name, memory_order_relaxed);
+        const bool end = atomic_load_explicit(&e->end, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&r->count, memory_order_relaxed) - i >= TRACE_EVENTS) {
+            depth = 0;      // overwritten while being read, as were all events before it
+            continue;
+        }
+        if (end && !depth)
+            continue;
+        depth += end ? -1 : 1;
+
+        fprintf(f, "%s\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u}",
+                first ? "" : ",", name, end ? 'E' : 'B', (double) (ns - start) / 1e3, tid);
+        first = false;
+    }
+    return first;
+}
+
+
+bool trace_write(FILE *f) {
+    Ring *all = atomic_load_explicit(&rings, memory_order_acquire);
+    const unsigned claimed = atomic_load(&ringCount);
+    const uint64_t start = atomic_load(&origin);
+
+    fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", f);
+    bool first = true;
+    for (unsigned i = 0; all && i < claimed && i < TRACE_THREADS; ++i)
+        first = writeRing(f, &all[i], i, start, first);
+    fputs("\n]}\n", f);
+    return fflush(f) || ferror(f);
+}
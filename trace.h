@@ -0,0 +1,58 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_TRACE_H
+#define GAMEOFLIFE_TRACE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define TRACE_THREADS 16        // threads that can be traced; later ones are not
+#define TRACE_EVENTS 32768      // latest events kept per thread
+
+/*
+ * Timeline tracing. Every thread records begin and end events into a ring of its own, which is
+ * claimed on its first event from rings allocated by trace_enable(); recording is lock-free,
+ * allocation-free and does nothing while tracing is disabled. The rings can be written as
+ * Chrome trace event JSON at any time, which chrome://tracing and Perfetto display.
+ */
+
+/**
+ * Allocate the rings, if not done before, and start recording. Must not be called by several threads at once.
+ * @return true if the rings could not be allocated
+ */
+bool trace_enable(void);
+
+/**
+ * @return whether events are recorded
+ */
+bool trace_enabled(void);
+
+/**
+ * Begin a span on the calling thread. Spans must nest.
+ * @param name name of the span; must stay valid until the trace is written, e.g. a string literal
+ */
+void trace_begin(const char *name);
+
+/**
+ * End the innermost span of the calling thread.
+ * @param name name of the span, as passed to trace_begin()
+ */
+void trace_end(const char *name);
+
+/**
+ * Name the calling thread in the trace; may be called before tracing is enabled.
+ * @param name name of the thread; must stay valid until the trace is written
+ */
+void trace_nameThread(const char *name);
+
+/**
+ * Write the events currently held by the rings as Chrome trace event JSON, while recording goes on.
+ * Events overwritten during writing are left out, as are end events whose beginning has been overwritten.
+ * @param f output file
+ * @return true if writing failed
+ */
+bool trace_write(FILE *f);
+
+#endif //GAMEOFLIFE_TRACE_H
@@ -0,0 +1,39 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#include "world.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+
+GOL_Universe *world_create(struct GOL_Pattern patinfo, struct GOL_Options options, bool detectPeriods) {
+    GOL_Cells *cells = NULL;
+    if (patinfo.pattern && patinfo.type == GOL_PLAINTEXT)
+        cells = gol_readPlaintext(patinfo.pattern);
+    if (patinfo.pattern && patinfo.type == GOL_RLE)
+        cells = gol_readRLE(patinfo.pattern);
+
+    const GOL_Settings settings = {
+            .engine = options.engine,
+            .rules = patinfo.rules ? patinfo.rules : cells ? gol_cellsRules(cells) : NULL,
+            .topology = options.topology,
+            .threads = options.threads,
+            .memoryBudget = (uint64_t) options.memoryBudget << 20,
+            .detectPeriods = detectPeriods
+    };
+    GOL_Universe *u = gol_create(&settings);
+    if (!u) {
+        fprintf(stderr, "Could not create the world.\n");
+        abort();
+    }
+
+    if (cells)
+        gol_load(u, cells);
+    gol_freeCells(cells);
+    if (patinfo.freeRulestring)
+        free((void *) patinfo.rules);
+    if (patinfo.freePattern)
+        free((void *) patinfo.pattern);
+    return u;
+}
@@ -0,0 +1,22 @@
+//
+// Created by easy on 16.10.26.
+//
+
+#ifndef GAMEOFLIFE_WORLD_H
+#define GAMEOFLIFE_WORLD_H
+
+#include "gameoflife.h"
+#include "gol.h"
+
+/**
+ * Create a universe from the options of a front end and load the pattern into it.
+ * Invalid options are reported to stderr and replaced by defaults. Aborts if the universe cannot be created.
+ * The pattern and rulestring of patinfo are freed if it asks for it.
+ * @param patinfo pattern to load
+ * @param options engine options
+ * @param detectPeriods whether the universe should detect periodic states
+ * @return the universe
+ */
+GOL_Universe *world_create(struct GOL_Pattern patinfo, struct GOL_Options options, bool detectPeriods);
+
+#endif //GAMEOFLIFE_WORLD_H